@@ -1,26 +1,79 @@
+#include <stdlib.h>
 #include <string.h>
 #include "bertlv.h"
+#include "bertlv_stats.h"
 
 static const uint8_t tag_mask_first         = 0x1F;
+static const uint8_t tag_mask_constructed   = 0x20;
 static const uint8_t tag_mask_more          = 0x80;
 static const uint8_t len_mask_long_format   = 0x80;
 
+/*
+ * Properties of tags be decided by the first tag byte,
+ * each item contains the class (bit 0-1), type (bit 2),
+ * and if the tag number is in subsequent bytes (bit 3).
+ */
+enum
+{
+    tag_prop_class      = 0x03,
+    tag_prop_type       = 0x04,
+    tag_prop_multibyte  = 0x08,
+};
+
+#define TAG_PROPS(b)    ( ( (b) >> 6 ) | ( ( (b) >> 3 ) & 0x04 ) | ( ( ( (b) & 0x1F ) == 0x1F ) << 3 ) )
+#define TAG_PROPS_4(b)  TAG_PROPS(b), TAG_PROPS(b+1), TAG_PROPS(b+2), TAG_PROPS(b+3)
+#define TAG_PROPS_16(b) TAG_PROPS_4(b), TAG_PROPS_4(b+4), TAG_PROPS_4(b+8), TAG_PROPS_4(b+12)
+#define TAG_PROPS_64(b) TAG_PROPS_16(b), TAG_PROPS_16(b+16), TAG_PROPS_16(b+32), TAG_PROPS_16(b+48)
+
+static const uint8_t tag_first_props[256] =
+{
+    TAG_PROPS_64(0x00), TAG_PROPS_64(0x40), TAG_PROPS_64(0x80), TAG_PROPS_64(0xC0)
+};
+
+#undef TAG_PROPS
+#undef TAG_PROPS_4
+#undef TAG_PROPS_16
+#undef TAG_PROPS_64
+
+static const bertlv_tag_t tag_more_bits_all = (bertlv_tag_t)0x8080808080808080ULL;
+
 //------------------------------------------------------------------------------
 //---- Tag ---------------------------------------------------------------------
 //------------------------------------------------------------------------------
-static
+static inline
 size_t bertlv_tag_calc_encode_size(bertlv_tag_t tag)
 {
+#ifdef __GNUC__
+    return tag ? ( 8*sizeof(tag) - __builtin_clzl(tag) + 7 ) / 8 : 0;
+#else
     size_t count;
     for(count = 0; tag; ++count, tag >>= 8)
     {}
 
     return count;
+#endif
+}
+//------------------------------------------------------------------------------
+static inline
+uint8_t bertlv_tag_get_first_byte(bertlv_tag_t tag)
+{
+    size_t size = bertlv_tag_calc_encode_size(tag);
+    return size ? tag >> 8*( size - 1 ) : 0;
 }
 //------------------------------------------------------------------------------
-static
 size_t bertlv_tag_encode(void *buf, size_t bufsize, bertlv_tag_t tag)
 {
+    /**
+     * Encode a tag field.
+     *
+     * @param buf     A buffer to be filled by the encoded tag,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @param tag     The tag value.
+     * @return It returns the size of data be filled to the output buffer if succeed; or
+     *         ZERO if the buffer is not large enough or the tag is ZERO; or
+     *         The minimum size of output buffer that will be needed if @a buf was NULL.
+     */
     size_t tagsize = bertlv_tag_calc_encode_size(tag);
     if( !buf ) return tagsize;
 
@@ -37,34 +90,47 @@ size_t bertlv_tag_encode(void *buf, size_t bufsize, bertlv_tag_t tag)
 }
 //------------------------------------------------------------------------------
 static
-size_t bertlv_tag_calc_decode_size(const uint8_t *data)
+size_t bertlv_tag_decode(const void *data, bertlv_tag_t *tag)
 {
-    if( !(*data) ) return 0;
+    const uint8_t *pos = data;
+    if( !pos[0] ) return 0;
 
-    if( ( *data & tag_mask_first ) != tag_mask_first ) return 1;
+    *tag = pos[0];
+    if( ( pos[0] & tag_mask_first ) != tag_mask_first ) return 1;
 
-    size_t count = 2;
-    for(++data; *data & tag_mask_more; ++data, ++count)
-    {}
+    size_t size = 1;
+    do
+    {
+        *tag <<= 8;
+        *tag |= pos[size];
+    } while( pos[size++] & tag_mask_more );
 
-    return count;
+    return size;
 }
 //------------------------------------------------------------------------------
 static
-size_t bertlv_tag_decode(const void *data, bertlv_tag_t *tag)
+int bertlv_tag_decode_s(const void *data, size_t size, bertlv_tag_t *tag, size_t *tagsize)
 {
     const uint8_t *pos = data;
-    size_t size = bertlv_tag_calc_decode_size(pos);
-    if( !size ) return 0;
+    if( !size ) return BERTLV_ERR_TRUNCATED;
+    if( !pos[0] ) return BERTLV_ERR_NULL_TAG;
 
-    *tag = 0;
-    for(size_t i=0; i<size; ++i)
+    size_t count = 1;
+    *tag = pos[0];
+    if( ( pos[0] & tag_mask_first ) == tag_mask_first )
     {
-        *tag <<= 8;
-        *tag |= pos[i];
+        do
+        {
+            if( count >= sizeof(bertlv_tag_t) ) return BERTLV_ERR_TAG_TOO_LONG;
+            if( count >= size ) return BERTLV_ERR_TRUNCATED;
+
+            *tag <<= 8;
+            *tag |= pos[count];
+        } while( pos[count++] & tag_mask_more );
     }
 
-    return size;
+    *tagsize = count;
+    return BERTLV_OK;
 }
 //------------------------------------------------------------------------------
 static
@@ -122,15 +188,19 @@ bool bertlv_tag_is_valid(bertlv_tag_t tag)
     /**
      * Check if a specific tag is a valid tag.
      */
-    if( !tag ) return false;
+    size_t size = bertlv_tag_calc_encode_size(tag);
+    if( !size ) return false;
 
-    uint8_t raw[16];
-    if( !bertlv_tag_encode(raw, sizeof(raw), tag) ) return false;
+    uint8_t first = tag >> 8*( size - 1 );
+    if( !( tag_first_props[first] & tag_prop_multibyte ) ) return size == 1;
+    if( size < 2 ) return false;
 
-    bertlv_tag_t tag2;
-    if( !bertlv_tag_decode(raw, &tag2) ) return false;
+    // The last byte ends the tag, and all bytes between must have the "more" bit.
+    bertlv_tag_t more_bits = ~(bertlv_tag_t)0 >> ( 8*( sizeof(bertlv_tag_t) - size + 1 ) );
+    more_bits &= tag_more_bits_all;
+    more_bits &= ~(bertlv_tag_t)0xFF;
 
-    return tag == tag2;
+    return ( tag & ( more_bits | 0x80 ) ) == more_bits;
 }
 //------------------------------------------------------------------------------
 int bertlv_tag_get_class(bertlv_tag_t tag)
@@ -138,10 +208,8 @@ int bertlv_tag_get_class(bertlv_tag_t tag)
     /**
      * Get the class value of a specific tag.
      */
-    uint8_t raw[16];
-    if( !bertlv_tag_encode(raw, sizeof(raw), tag) ) return 0;
-
-    return ( raw[0] & 0xC0 ) >> 6;
+    if( !tag ) return 0;
+    return tag_first_props[bertlv_tag_get_first_byte(tag)] & tag_prop_class;
 }
 //------------------------------------------------------------------------------
 int bertlv_tag_get_type(bertlv_tag_t tag)
@@ -149,10 +217,8 @@ int bertlv_tag_get_type(bertlv_tag_t tag)
     /**
      * Get the type value of a specific tag.
      */
-    uint8_t raw[16];
-    if( !bertlv_tag_encode(raw, sizeof(raw), tag) ) return 0;
-
-    return ( raw[0] & 0x20 ) >> 5;
+    if( !tag ) return 0;
+    return ( tag_first_props[bertlv_tag_get_first_byte(tag)] & tag_prop_type ) >> 2;
 }
 //------------------------------------------------------------------------------
 long bertlv_tag_get_number(bertlv_tag_t tag)
@@ -160,18 +226,18 @@ long bertlv_tag_get_number(bertlv_tag_t tag)
     /**
      * Get the number of a specific tag.
      */
-    uint8_t raw[16];
-    size_t size = bertlv_tag_encode(raw, sizeof(raw), tag);
-    if( !size ) return 0;
+    if( !tag ) return 0;
 
-    if( ( raw[0] & tag_mask_first ) != tag_mask_first )
-        return raw[0] & tag_mask_first;
+    size_t  size  = bertlv_tag_calc_encode_size(tag);
+    uint8_t first = tag >> 8*( size - 1 );
+    if( !( tag_first_props[first] & tag_prop_multibyte ) )
+        return first & tag_mask_first;
 
     long num = 0;
-    for(size_t i=1; i<size; ++i)
+    for(size_t i = size - 1; i--; )
     {
         num <<= 7;
-        num |= raw[i] & ~tag_mask_more;
+        num |= ( tag >> 8*i ) & ~tag_mask_more & 0xFF;
     }
 
     return num;
@@ -180,7 +246,7 @@ long bertlv_tag_get_number(bertlv_tag_t tag)
 //---- Length Field ------------------------------------------------------------
 //------------------------------------------------------------------------------
 static
-size_t bertlv_len_calc_encode_size(size_t length)
+size_t bertlv_len_calc_encode_size(uint64_t length)
 {
     if( length <= 0x7F ) return 1;
 
@@ -191,9 +257,35 @@ size_t bertlv_len_calc_encode_size(size_t length)
     return count + 1;
 }
 //------------------------------------------------------------------------------
-static
 size_t bertlv_len_encode(void *buf, size_t bufsize, size_t length)
 {
+    /**
+     * Encode a length field in the shortest form.
+     *
+     * @param buf     A buffer to be filled by the encoded length,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @param length  The length value.
+     * @return It returns the size of data be filled to the output buffer if succeed; or
+     *         ZERO if the buffer is not large enough; or
+     *         The minimum size of output buffer that will be needed if @a buf was NULL.
+     */
+    return bertlv_len_encode64(buf, bufsize, length);
+}
+//------------------------------------------------------------------------------
+size_t bertlv_len_encode64(void *buf, size_t bufsize, uint64_t length)
+{
+    /**
+     * Encode a 64-bit length field in the shortest form.
+     *
+     * @param buf     A buffer to be filled by the encoded length,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @param length  The length value.
+     * @return It returns the size of data be filled to the output buffer if succeed; or
+     *         ZERO if the buffer is not large enough; or
+     *         The minimum size of output buffer that will be needed if @a buf was NULL.
+     */
     size_t lensize = bertlv_len_calc_encode_size(length);
     if( !buf ) return lensize;
 
@@ -219,6 +311,24 @@ size_t bertlv_len_encode(void *buf, size_t bufsize, size_t length)
 }
 //------------------------------------------------------------------------------
 static
+void bertlv_len_encode_fixed(void *buf, size_t lensize, size_t length)
+{
+    // Encode the length with exactly the specified field size,
+    // and the long format will be padded with leading zeros if needed.
+    uint8_t *pos = buf;
+
+    if( lensize == 1 )
+    {
+        pos[0] = length;
+        return;
+    }
+
+    pos[0] = 0x80 | ( lensize - 1 );
+    for(size_t i=lensize-1; i; --i, length >>= 8)
+        pos[i] = length & 0xFF;
+}
+//------------------------------------------------------------------------------
+static
 size_t bertlv_len_calc_decode_size(const uint8_t *data)
 {
     if( !( *data & len_mask_long_format ) ) return 1;
@@ -234,7 +344,7 @@ size_t bertlv_len_decode(const void *data, size_t *length)
 {
     const uint8_t *pos = data;
     size_t size = bertlv_len_calc_decode_size(pos);
-    if( !size ) return 0;
+    if( !size || size - 1 > sizeof(size_t) ) return 0;
 
     if( size == 1 )
     {
@@ -253,6 +363,49 @@ size_t bertlv_len_decode(const void *data, size_t *length)
     return size;
 }
 //------------------------------------------------------------------------------
+int bertlv_len_decode64(const void *data, size_t size, uint64_t *length, size_t *lensize)
+{
+    /**
+     * Decode a definite length field into 64-bit without reading past the input size.
+     *
+     * @param data    The length field to be parsed.
+     * @param size    Size of the input data.
+     * @param length  Receives the length value.
+     * @param lensize Receives size of the length field.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_TRUNCATED if the field runs past the end of the input; or
+     *         ::BERTLV_ERR_BAD_LENGTH if the field is indefinite or reserved; or
+     *         ::BERTLV_ERR_LENGTH_TOO_LONG if the field is longer than 8 bytes.
+     *
+     * @remarks The value is accumulated in `uint64_t` on all platforms,
+     *          so the caller can check it against `size_t` itself.
+     */
+    const uint8_t *pos = data;
+    if( !size ) return BERTLV_ERR_TRUNCATED;
+
+    if( !( pos[0] & len_mask_long_format ) )
+    {
+        *length  = pos[0];
+        *lensize = 1;
+        return BERTLV_OK;
+    }
+
+    size_t subsequence_count = pos[0] & ~len_mask_long_format;
+    if( subsequence_count == 0 || subsequence_count == 0x7F ) return BERTLV_ERR_BAD_LENGTH;
+    if( subsequence_count > sizeof(uint64_t) ) return BERTLV_ERR_LENGTH_TOO_LONG;
+    if( subsequence_count >= size ) return BERTLV_ERR_TRUNCATED;
+
+    *length = 0;
+    for(size_t i=1; i<=subsequence_count; ++i)
+    {
+        *length <<= 8;
+        *length |= pos[i];
+    }
+
+    *lensize = 1 + subsequence_count;
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
 //---- TLV Element -------------------------------------------------------------
 //------------------------------------------------------------------------------
 size_t bertlv_encode(void *buf, size_t bufsize, bertlv_tag_t tag, const void *data, size_t size)
@@ -290,7 +443,7 @@ size_t bertlv_encode(void *buf, size_t bufsize, bertlv_tag_t tag, const void *da
         rest -= len_size;
 
         if( rest < size ) return 0;
-        memcpy(pos, data, size);
+        if( size ) memcpy(pos, data, size);
 
         return tag_size + len_size + size;
     }
@@ -302,6 +455,38 @@ size_t bertlv_encode(void *buf, size_t bufsize, bertlv_tag_t tag, const void *da
     }
 }
 //------------------------------------------------------------------------------
+size_t bertlv_decode_header(const void *tlv, bertlv_header_t *header)
+{
+    /**
+     * Decode the tag and length fields of a TLV element in one pass.
+     *
+     * @param tlv    The TLV data to be parsed.
+     * @param header Receives the decoded header information.
+     * @return The total size of the TLV data if succeed; or
+     *         ZERO if the TLV is NULL or have incorrect format
+     *         (the content of @a header is undefined in that case).
+     */
+    const uint8_t *pos = tlv;
+    if( !pos ) return 0;
+
+    size_t tag_size = bertlv_tag_decode(pos, &header->tag);
+    if( !tag_size ) return 0;
+    pos += tag_size;
+
+    size_t len_size = bertlv_len_decode(pos, &header->length);
+    if( !len_size ) return 0;
+    if( header->length > SIZE_MAX - tag_size - len_size ) return 0;
+    pos += len_size;
+
+    header->tag_size   = tag_size;
+    header->len_size   = len_size;
+    header->value      = pos;
+    header->total_size = tag_size + len_size + header->length;
+    header->indefinite = false;
+
+    return header->total_size;
+}
+//------------------------------------------------------------------------------
 bertlv_tag_t bertlv_get_tag(const void *tlv)
 {
     /**
@@ -324,15 +509,8 @@ size_t bertlv_get_length(const void *tlv)
      * @return The size (including zero) of payload data if succeed; or
      *         ZERO if the TLV is NULL or have incorrect format.
      */
-    const uint8_t *pos = tlv;
-    if( !pos ) return 0;
-
-    size_t tag_size = bertlv_tag_calc_decode_size(pos);
-    if( !tag_size ) return 0;
-    pos += tag_size;
-
-    size_t len_value;
-    return bertlv_len_decode(pos, &len_value) ? len_value : 0;
+    bertlv_header_t header;
+    return bertlv_decode_header(tlv, &header) ? header.length : 0;
 }
 //------------------------------------------------------------------------------
 const void* bertlv_get_value(const void *tlv)
@@ -345,18 +523,8 @@ const void* bertlv_get_value(const void *tlv)
      *         (no matter if the TLV have payload or not) if succeed; or
      *         NULL if the TLV is NULL or have incorrect format.
      */
-    const uint8_t *pos = tlv;
-    if( !pos ) return NULL;
-
-    size_t tag_size = bertlv_tag_calc_decode_size(pos);
-    if( !tag_size ) return NULL;
-    pos += tag_size;
-
-    size_t len_size = bertlv_len_calc_decode_size(pos);
-    if( !len_size ) return NULL;
-    pos += len_size;
-
-    return pos;
+    bertlv_header_t header;
+    return bertlv_decode_header(tlv, &header) ? header.value : NULL;
 }
 //------------------------------------------------------------------------------
 size_t bertlv_get_total_size(const void *tlv)
@@ -368,57 +536,301 @@ size_t bertlv_get_total_size(const void *tlv)
      * @return The total size of the TLV data if succeed; or
      *         ZERO if the TLV is NULL or have incorrect format.
      */
-    const uint8_t *pos = tlv;
-    if( !pos ) return 0;
+    bertlv_header_t header;
+    return bertlv_decode_header(tlv, &header);
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_find_eoc(const uint8_t *data, size_t size, size_t *length)
+{
+    // Find the end-of-contents of an indefinite length element in one pass,
+    // definite children are skipped by their sizes,
+    // and indefinite ones are tracked by the number of levels opened.
+    const uint8_t *pos    = data;
+    unsigned       levels = 1;
+    while( true )
+    {
+        if( size < 2 ) return BERTLV_ERR_OVERRUN;
 
-    size_t tag_size = bertlv_tag_calc_decode_size(pos);
-    if( !tag_size ) return 0;
-    pos += tag_size;
+        if( !pos[0] && !pos[1] )
+        {
+            pos  += 2;
+            size -= 2;
 
-    size_t len_value;
-    size_t len_size = bertlv_len_decode(pos, &len_value);
-    if( !len_size ) return 0;
+            if( !--levels ) break;
+            continue;
+        }
+
+        bertlv_tag_t tag;
+        size_t       tag_size;
+        int err = bertlv_tag_decode_s(pos, size, &tag, &tag_size);
+        if( err ) return err;
 
-    return tag_size + len_size + len_value;
+        if( size > tag_size && pos[tag_size] == len_mask_long_format )
+        {
+            if( !( pos[0] & tag_mask_constructed ) ) return BERTLV_ERR_BAD_LENGTH;
+            if( levels >= BERTLV_TREE_DEPTH_MAX ) return BERTLV_ERR_TOO_DEEP;
+
+            ++levels;
+            pos  += tag_size + 1;
+            size -= tag_size + 1;
+            continue;
+        }
+
+        uint64_t child;
+        size_t   len_size;
+        err = bertlv_len_decode64(pos + tag_size, size - tag_size, &child, &len_size);
+        if( err ) return err;
+        if( child > size - tag_size - len_size ) return BERTLV_ERR_OVERRUN;
+
+        pos  += tag_size + len_size + child;
+        size -= tag_size + len_size + child;
+    }
+
+    *length = pos - data - 2;
+    return BERTLV_OK;
 }
 //------------------------------------------------------------------------------
-//---- TLV group ---------------------------------------------------------------
+int bertlv_decode_header_s(const void *tlv, size_t size, bertlv_header_t *header)
+{
+    /**
+     * Decode the header of a TLV element without reading past the input size.
+     *
+     * @param tlv    The TLV data to be parsed.
+     * @param size   Size of the input data,
+     *               and it can be larger than the size of the TLV element.
+     * @param header Receives the decoded header information.
+     * @return ::BERTLV_OK if succeed; or
+     *         one of ::bertlv_error_t values to describe the format error
+     *         (the content of @a header is undefined in that case).
+     *
+     * @remarks The element is valid only if its payload is also inside the input data,
+     *          and ::BERTLV_ERR_OVERRUN will be returned if it is not.
+     * @remarks Constructed elements with indefinite length (0x80) are supported,
+     *          and the payload size is found by skipping the children
+     *          to the matched end-of-contents (00 00).
+     *          The payload excludes the end-of-contents, so that
+     *          it can be iterated as a group as well as definite ones.
+     */
+    const uint8_t *pos = tlv;
+    if( !pos ) return BERTLV_ERR_TRUNCATED;
+
+    size_t tag_size;
+    int err = bertlv_tag_decode_s(pos, size, &header->tag, &tag_size);
+    if( err ) return err;
+    pos  += tag_size;
+    size -= tag_size;
+
+    if( size && *pos == len_mask_long_format )
+    {
+        if( !( *(const uint8_t*)tlv & tag_mask_constructed ) ) return BERTLV_ERR_BAD_LENGTH;
+
+        err = bertlv_find_eoc(pos + 1, size - 1, &header->length);
+        if( err ) return err;
+
+        header->tag_size   = tag_size;
+        header->len_size   = 1;
+        header->value      = pos + 1;
+        header->total_size = tag_size + 1 + header->length + 2;
+        header->indefinite = true;
+
+        return BERTLV_OK;
+    }
+
+    // The length is compared with the input size in 64-bit,
+    // so the total size below can never overflow.
+    uint64_t length;
+    size_t   len_size;
+    err = bertlv_len_decode64(pos, size, &length, &len_size);
+    if( err ) return err;
+    pos  += len_size;
+    size -= len_size;
+
+    if( length > size ) return BERTLV_ERR_OVERRUN;
+
+    header->length     = length;
+    header->tag_size   = tag_size;
+    header->len_size   = len_size;
+    header->value      = pos;
+    header->total_size = tag_size + len_size + header->length;
+    header->indefinite = false;
+
+    return BERTLV_OK;
+}
 //------------------------------------------------------------------------------
-const void* bertlv_iter_get_next(bertlv_iter_t *iter)
+int bertlv_decode_header64(const void *tlv, size_t size, bertlv_header64_t *header)
 {
     /**
-     * @memberof bertlv_iter_t
-     * @brief Get the next TLV element.
+     * Decode the header of a TLV element with 64-bit sizes.
      *
-     * @param iter The iterator object.
-     * @return The next TLV element if found; or
-     *         NULL if no more elements.
+     * @param tlv    The TLV data to be parsed.
+     * @param size   Size of the input data,
+     *               and only the tag and length fields need to be inside it.
+     * @param header Receives the decoded header information.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_LENGTH_TOO_LONG if the total size overflows `uint64_t`; or
+     *         other ::bertlv_error_t values to describe the format error.
+     *
+     * @remarks The payload is not checked, and
+     *          the end of an indefinite length element is not searched.
      */
-    if( !iter->pos ) return NULL;
+    const uint8_t *pos = tlv;
+    if( !pos ) return BERTLV_ERR_TRUNCATED;
 
-    const void *tlv = NULL;
+    size_t tag_size;
+    int err = bertlv_tag_decode_s(pos, size, &header->tag, &tag_size);
+    if( err ) return err;
 
-    do
+    header->tag_size   = tag_size;
+    header->indefinite = false;
+
+    if( size > tag_size && pos[tag_size] == len_mask_long_format )
     {
-        static const size_t tlvsize_min = 2;
-        if( iter->size < tlvsize_min ) break;
+        if( !( pos[0] & tag_mask_constructed ) ) return BERTLV_ERR_BAD_LENGTH;
+
+        header->length     = 0;
+        header->len_size   = 1;
+        header->total_size = 0;
+        header->indefinite = true;
+        return BERTLV_OK;
+    }
 
-        size_t tlvsize = bertlv_get_total_size(iter->pos);
-        if( !tlvsize || tlvsize > iter->size ) break;
+    err = bertlv_len_decode64(pos + tag_size, size - tag_size, &header->length, &header->len_size);
+    if( err ) return err;
 
-        tlv = iter->pos;
+    uint64_t head_size = tag_size + header->len_size;
+    if( header->length > UINT64_MAX - head_size ) return BERTLV_ERR_LENGTH_TOO_LONG;
 
-        iter->pos  += tlvsize;
-        iter->size -= tlvsize;
-    } while(false);
+    header->total_size = head_size + header->length;
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+bertlv_tag_t bertlv_get_tag_s(const void *tlv, size_t size)
+{
+    /**
+     * Get the tag value of a specified TLV data, with bounds checking.
+     *
+     * @param tlv  The TLV data to be parsed.
+     * @param size Size of the input data.
+     * @return The tag value of the TLV data if succeed; or
+     *         ZERO if the TLV is NULL, have incorrect format, or not inside the input data.
+     */
+    bertlv_header_t header;
+    return bertlv_decode_header_s(tlv, size, &header) ? 0 : header.tag;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_get_length_s(const void *tlv, size_t size)
+{
+    /**
+     * Get the payload size of a specified TLV data, with bounds checking.
+     *
+     * @param tlv  The TLV data to be parsed.
+     * @param size Size of the input data.
+     * @return The size (including zero) of payload data if succeed; or
+     *         ZERO if the TLV is NULL, have incorrect format, or not inside the input data.
+     */
+    bertlv_header_t header;
+    return bertlv_decode_header_s(tlv, size, &header) ? 0 : header.length;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_get_value_s(const void *tlv, size_t size)
+{
+    /**
+     * Get the payload data of a specified TLV data, with bounds checking.
+     *
+     * @param tlv  The TLV data to be parsed.
+     * @param size Size of the input data.
+     * @return A pointer be pointed to the payload data
+     *         (no matter if the TLV have payload or not) if succeed; or
+     *         NULL if the TLV is NULL, have incorrect format, or not inside the input data.
+     */
+    bertlv_header_t header;
+    return bertlv_decode_header_s(tlv, size, &header) ? NULL : header.value;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_get_total_size_s(const void *tlv, size_t size)
+{
+    /**
+     * Calculate size of raw data of a specific TLV data, with bounds checking.
+     *
+     * @param tlv  The TLV data to be parsed.
+     * @param size Size of the input data.
+     * @return The total size of the TLV data if succeed; or
+     *         ZERO if the TLV is NULL, have incorrect format, or not inside the input data.
+     */
+    bertlv_header_t header;
+    return bertlv_decode_header_s(tlv, size, &header) ? 0 : header.total_size;
+}
+//------------------------------------------------------------------------------
+//---- TLV group ---------------------------------------------------------------
+//------------------------------------------------------------------------------
+static inline
+const void* bertlv_iter_next(bertlv_iter_t *iter, bertlv_header_t *header)
+{
+    if( !iter->pos ) return NULL;
+
+    if( !iter->size )
+    {
+        iter->pos = NULL;
+        return NULL;
+    }
 
-    if( !tlv )
+    int err = bertlv_decode_header_s(iter->pos, iter->size, header);
+    if( err )
     {
         iter->pos  = NULL;
         iter->size = 0;
+        iter->err  = err;
+        return NULL;
     }
 
+    const void *tlv = iter->pos;
+
+    iter->pos  += header->total_size;
+    iter->size -= header->total_size;
+
+    return tlv;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_iter_get_next_header(bertlv_iter_t *iter, bertlv_header_t *header)
+{
+    /**
+     * @memberof bertlv_iter_t
+     * @brief Get the next TLV element and its decoded header.
+     *
+     * @param iter   The iterator object.
+     * @param header Receives the header information of the element returned.
+     * @return The next TLV element if found; or
+     *         NULL if no more elements or the next element is malformed
+     *         (::bertlv_iter_get_error can tell which one).
+     */
+#ifdef BERTLV_STATS
+    bool active = iter->pos;
+
+    const void *tlv = bertlv_iter_next(iter, header);
+    if( tlv )
+        BERTLV_STATS_ELEMENT("iter", header->total_size, 0);
+    else if( active && iter->err )
+        BERTLV_STATS_ERROR("iter", iter->err);
+
     return tlv;
+#else
+    return bertlv_iter_next(iter, header);
+#endif
+}
+//------------------------------------------------------------------------------
+const void* bertlv_iter_get_next(bertlv_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_iter_t
+     * @brief Get the next TLV element.
+     *
+     * @param iter The iterator object.
+     * @return The next TLV element if found; or
+     *         NULL if no more elements.
+     */
+    bertlv_header_t header;
+    return bertlv_iter_get_next_header(iter, &header);
 }
 //------------------------------------------------------------------------------
 unsigned bertlv_grp_count(const void *group, size_t size)
@@ -432,9 +844,10 @@ unsigned bertlv_grp_count(const void *group, size_t size)
      */
     unsigned count = 0;
 
-    bertlv_iter_t iter;
+    bertlv_header_t header;
+    bertlv_iter_t   iter;
     bertlv_iter_init(&iter, group, size);
-    while( bertlv_iter_get_next(&iter) )
+    while( bertlv_iter_get_next_header(&iter, &header) )
         ++count;
 
     return count;
@@ -451,17 +864,76 @@ const void* bertlv_grp_find(const void *group, size_t size, bertlv_tag_t tag)
      * @return The TLV element in the group if found; or
      *         NULL if not found.
      */
-    bertlv_iter_t iter;
+    bertlv_header_t header;
+    bertlv_iter_t   iter;
     bertlv_iter_init(&iter, group, size);
-    for(const void *tlv; ( tlv = bertlv_iter_get_next(&iter) ); )
+    for(const void *tlv; ( tlv = bertlv_iter_get_next_header(&iter, &header) ); )
     {
-        if( bertlv_get_tag(tlv) == tag )
+        if( header.tag == tag )
             return tlv;
     }
 
     return NULL;
 }
 //------------------------------------------------------------------------------
+static inline
+unsigned bertlv_tag_hash(bertlv_tag_t tag)
+{
+    // An 8-bit hash of tag for the membership filter.
+    return (uint64_t)tag * 0x9E3779B97F4A7C15ULL >> 56;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_grp_find_many(const void         *group,
+                            size_t              size,
+                            const bertlv_tag_t *tags,
+                            size_t              ntags,
+                            const void        **out)
+{
+    /**
+     * Find several TLV elements in a group of TLV data by tags in one pass.
+     *
+     * @param group The set of raw data of TLV elements.
+     * @param size  Size of the input data.
+     * @param tags  Tags of the TLV elements to find.
+     * @param ntags Number of tags.
+     * @param out   Receives the first TLV element of each tag,
+     *              or NULL if not found, in the same order of @a tags.
+     * @return Number of tags that be found.
+     *
+     * @remarks Elements that cannot be in the list will be rejected by a small bitmap filter,
+     *          and the walk stops as soon as all tags be found.
+     */
+    uint64_t filter[4] = {0};
+    for(size_t i=0; i<ntags; ++i)
+    {
+        unsigned hash = bertlv_tag_hash(tags[i]);
+        filter[ hash >> 6 ] |= (uint64_t)1 << ( hash & 63 );
+        out[i] = NULL;
+    }
+
+    size_t rest = ntags;
+
+    bertlv_header_t header;
+    bertlv_iter_t   iter;
+    bertlv_iter_init(&iter, group, size);
+    for(const void *tlv; rest && ( tlv = bertlv_iter_get_next_header(&iter, &header) ); )
+    {
+        unsigned hash = bertlv_tag_hash(header.tag);
+        if( !( filter[ hash >> 6 ] & ( (uint64_t)1 << ( hash & 63 ) ) ) ) continue;
+
+        for(size_t i=0; i<ntags; ++i)
+        {
+            if( !out[i] && tags[i] == header.tag )
+            {
+                out[i] = tlv;
+                --rest;
+            }
+        }
+    }
+
+    return ntags - rest;
+}
+//------------------------------------------------------------------------------
 size_t bertlv_grp_calc_total_size(const void *group, size_t size)
 {
     /**
@@ -473,11 +945,1383 @@ size_t bertlv_grp_calc_total_size(const void *group, size_t size)
      */
     size_t total_size = 0;
 
-    bertlv_iter_t iter;
+    bertlv_header_t header;
+    bertlv_iter_t   iter;
     bertlv_iter_init(&iter, group, size);
-    for(const void *tlv; ( tlv = bertlv_iter_get_next(&iter) ); )
-        total_size += bertlv_get_total_size(tlv);
+    while( bertlv_iter_get_next_header(&iter, &header) )
+        total_size += header.total_size;
 
     return total_size;
 }
 //------------------------------------------------------------------------------
+//---- TLV group scanning ------------------------------------------------------
+//------------------------------------------------------------------------------
+static inline
+size_t bertlv_scan_step(const uint8_t *group, size_t size, size_t pos)
+{
+    // Get size of the element at the position, or ZERO if it is malformed.
+    const uint8_t *tlv  = group + pos;
+    size_t         rest = size - pos;
+
+    // Fast paths of one- or two-byte tag and short length.
+    if( rest >= 3 && tlv[0] )
+    {
+        size_t tag_size = ( ( tlv[0] & tag_mask_first ) != tag_mask_first )?( 1 ):
+                          ( !( tlv[1] & tag_mask_more ) )?( 2 ):( 0 );
+        if( tag_size && !( tlv[tag_size] & len_mask_long_format ) )
+        {
+            size_t total = tag_size + 1 + tlv[tag_size];
+            return ( total <= rest )?( total ):( 0 );
+        }
+    }
+
+    bertlv_header_t header;
+    return bertlv_decode_header_s(tlv, rest, &header) ? 0 : header.total_size;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_grp_scan(const void *group, size_t size, size_t *offsets, size_t capacity)
+{
+    /**
+     * Find the offsets of all TLV elements in a group.
+     *
+     * @param group    The set of raw data of TLV elements.
+     * @param size     Size of the input data.
+     * @param offsets  An array to receive offsets of the elements,
+     *                 and it can be NULL to count elements only.
+     * @param capacity Number of items of the offset array.
+     * @return The number of TLV elements in the group,
+     *         and only the first @a capacity offsets will be filled
+     *         if the array is not large enough.
+     *
+     * @remarks This function produces the same elements as ::bertlv_iter_t does,
+     *          but elements with one- or two-byte tag and short length
+     *          (not more than 127) are measured without the general header decoding.
+     */
+    if( !group ) return 0;
+
+    size_t count = 0;
+    for(size_t pos = 0, total; pos < size; pos += total, ++count)
+    {
+        total = bertlv_scan_step(group, size, pos);
+        if( !total )
+        {
+#ifdef BERTLV_STATS
+            bertlv_header_t header;
+            BERTLV_STATS_ERROR("scan", bertlv_decode_header_s((const uint8_t*)group + pos, size - pos, &header));
+#endif
+            break;
+        }
+
+        BERTLV_STATS_ELEMENT("scan", total, 0);
+
+        if( offsets && count < capacity )
+            offsets[count] = pos;
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
+//---- TLV group index ---------------------------------------------------------
+//------------------------------------------------------------------------------
+static
+int bertlv_index_entry_compare(const void *a, const void *b)
+{
+    const bertlv_index_entry_t *entry1 = a;
+    const bertlv_index_entry_t *entry2 = b;
+
+    if( entry1->tag != entry2->tag )
+        return ( entry1->tag < entry2->tag )?( -1 ):( 1 );
+
+    // All elements are in the same group, so the address keeps their order.
+    const uint8_t *pos1 = entry1->tlv;
+    const uint8_t *pos2 = entry2->tlv;
+    return ( pos1 < pos2 )?( -1 ):( pos1 > pos2 );
+}
+//------------------------------------------------------------------------------
+static
+size_t bertlv_index_lower_bound(const bertlv_index_t *index, bertlv_tag_t tag)
+{
+    size_t lo = 0;
+    size_t hi = index->count;
+    while( lo < hi )
+    {
+        size_t mid = lo + ( hi - lo ) / 2;
+        if( index->entries[mid].tag < tag )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_index_build(bertlv_index_t       *index,
+                          bertlv_index_entry_t *entries,
+                          size_t                capacity,
+                          const void           *group,
+                          size_t                size)
+{
+    /**
+     * @memberof bertlv_index_t
+     * @brief Build a tag index of a TLV group in one pass.
+     *
+     * @param index    The index object.
+     * @param entries  The storage of index entries,
+     *                 and it can be NULL to calculate the number of entries that be needed.
+     * @param capacity Number of entries of the storage.
+     * @param group    The set of raw data of TLV elements.
+     * @param size     Size of the input data.
+     * @return The number of elements be indexed if succeed; or
+     *         ZERO if the storage is not large enough; or
+     *         The number of entries that will be needed if @a entries was NULL.
+     *
+     * @remarks The index refers to the elements in @a group directly,
+     *          so the group data must stay unchanged while the index is in use.
+     */
+    index->entries = NULL;
+    index->count   = 0;
+
+    size_t count = 0;
+
+    bertlv_header_t header;
+    bertlv_iter_t   iter;
+    bertlv_iter_init(&iter, group, size);
+    for(const void *tlv; ( tlv = bertlv_iter_get_next_header(&iter, &header) ); ++count)
+    {
+        if( !entries ) continue;
+        if( count >= capacity ) return 0;
+
+        entries[count].tag = header.tag;
+        entries[count].tlv = tlv;
+    }
+
+    if( !entries ) return count;
+
+    qsort(entries, count, sizeof(entries[0]), bertlv_index_entry_compare);
+
+    index->entries = entries;
+    index->count   = count;
+
+    return count;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_index_find(const bertlv_index_t *index, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_index_t
+     * @brief Find a TLV element by tag.
+     *
+     * @param index The index object.
+     * @param tag   Tag of the specific TLV element.
+     * @return The first TLV element (in order of the group) with the tag if found; or
+     *         NULL if not found.
+     */
+    size_t pos = bertlv_index_lower_bound(index, tag);
+    return ( pos < index->count && index->entries[pos].tag == tag )?
+           ( index->entries[pos].tlv ):( NULL );
+}
+//------------------------------------------------------------------------------
+size_t bertlv_index_find_all(const bertlv_index_t        *index,
+                             bertlv_tag_t                 tag,
+                             const bertlv_index_entry_t **first)
+{
+    /**
+     * @memberof bertlv_index_t
+     * @brief Find all TLV elements with the same tag.
+     *
+     * @param index The index object.
+     * @param tag   Tag of the specific TLV elements.
+     * @param first Receives the first entry of the elements found,
+     *              and the entries that follow it are in order of the group.
+     *              It will be set to NULL if nothing found.
+     * @return The number of elements found.
+     */
+    size_t begin = bertlv_index_lower_bound(index, tag);
+
+    size_t end;
+    for(end = begin; end < index->count && index->entries[end].tag == tag; ++end)
+    {}
+
+    *first = ( end > begin )?( &index->entries[begin] ):( NULL );
+    return end - begin;
+}
+//------------------------------------------------------------------------------
+//---- TLV tree ----------------------------------------------------------------
+//------------------------------------------------------------------------------
+static inline
+bool bertlv_is_constructed(const void *tlv)
+{
+    return *(const uint8_t*)tlv & tag_mask_constructed;
+}
+//------------------------------------------------------------------------------
+void bertlv_tree_iter_init(bertlv_tree_iter_t *iter, const void *group, size_t size)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Constructor.
+     *
+     * @param iter  The iterator it self.
+     * @param group A set of data of TLV elements.
+     * @param size  Size of the input data.
+     */
+    bertlv_iter_init(&iter->levels[0], group, size);
+    iter->depth      = 0;
+    iter->child      = NULL;
+    iter->child_size = 0;
+    iter->lazy       = false;
+    iter->entered    = false;
+    iter->err        = BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+void bertlv_tree_iter_init_lazy(bertlv_tree_iter_t *iter, const void *group, size_t size)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Constructor of lazy mode.
+     *
+     * @param iter  The iterator it self.
+     * @param group A set of data of TLV elements.
+     * @param size  Size of the input data.
+     *
+     * @remarks The iterator will not descend into a constructed element
+     *          unless ::bertlv_tree_iter_enter is called after it be returned.
+     */
+    bertlv_tree_iter_init(iter, group, size);
+    iter->lazy = true;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_tree_iter_get_next(bertlv_tree_iter_t *iter, bertlv_header_t *header)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Get the next TLV element in pre-order.
+     *
+     * @param iter   The iterator object.
+     * @param header Receives the header information of the element returned.
+     * @return The next TLV element if found; or
+     *         NULL if no more elements or an error occurred
+     *         (::bertlv_tree_iter_get_error can tell which one).
+     *
+     * @remarks If the element returned is constructed,
+     *          the next call will return its first child
+     *          unless ::bertlv_tree_iter_skip is called,
+     *          or ::bertlv_tree_iter_enter is not called in lazy mode.
+     */
+    if( iter->err ) return NULL;
+
+    bool descend = iter->child && ( !iter->lazy || iter->entered );
+    iter->entered = false;
+
+    if( descend )
+    {
+        if( iter->depth + 1 >= BERTLV_TREE_DEPTH_MAX )
+        {
+            BERTLV_STATS_ERROR("tree", BERTLV_ERR_TOO_DEEP);
+
+            iter->err = BERTLV_ERR_TOO_DEEP;
+            return NULL;
+        }
+
+        bertlv_iter_init(&iter->levels[++iter->depth], iter->child, iter->child_size);
+    }
+
+    iter->child = NULL;
+
+    while(true)
+    {
+        bertlv_iter_t *level = &iter->levels[iter->depth];
+
+        const void *tlv = bertlv_iter_next(level, header);
+        if( tlv )
+        {
+            BERTLV_STATS_ELEMENT("tree", header->total_size, iter->depth);
+
+            if( bertlv_is_constructed(tlv) )
+            {
+                iter->child      = header->value;
+                iter->child_size = header->length;
+            }
+
+            return tlv;
+        }
+
+        if( level->err )
+        {
+            BERTLV_STATS_ERROR("tree", level->err);
+
+            iter->err = level->err;
+            return NULL;
+        }
+
+        if( !iter->depth ) return NULL;
+        --iter->depth;
+    }
+}
+//------------------------------------------------------------------------------
+void bertlv_tree_iter_skip(bertlv_tree_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Do not descend into the last element returned.
+     *
+     * @param iter The iterator object.
+     */
+    iter->child   = NULL;
+    iter->entered = false;
+}
+//------------------------------------------------------------------------------
+bool bertlv_tree_iter_enter(bertlv_tree_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Descend into the last element returned.
+     *
+     * @param iter The iterator object.
+     * @return TRUE if the next call of ::bertlv_tree_iter_get_next will return its first child; or
+     *         FALSE if the last element is not constructed (or it has been skipped).
+     *
+     * @remarks It is needed in lazy mode only, since other iterators descend automatically.
+     */
+    iter->entered = iter->child;
+    return iter->entered;
+}
+//------------------------------------------------------------------------------
+void bertlv_tree_iter_leave(bertlv_tree_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Skip the rest of the level of the last element returned.
+     *
+     * @param iter The iterator object.
+     *
+     * @remarks The next call of ::bertlv_tree_iter_get_next will return
+     *          the next sibling of the parent element,
+     *          and the remaining elements of the level will not be decoded.
+     */
+    bertlv_tree_iter_skip(iter);
+    iter->levels[iter->depth].pos = NULL;
+}
+//------------------------------------------------------------------------------
+int bertlv_walk(const void *group, size_t size, bertlv_walk_cb_t callback, void *arg)
+{
+    /**
+     * Walk through all TLV elements of a group and their nested elements.
+     *
+     * @param group    The set of raw data of TLV elements.
+     * @param size     Size of the input data.
+     * @param callback The function to be called for each element in pre-order,
+     *                 and it decides whether to descend into constructed elements.
+     * @param arg      An user argument that will be passed to the callback.
+     * @return ::BERTLV_OK if all elements be visited or the callback stopped the walking; or
+     *         one of ::bertlv_error_t values if a malformed element was found.
+     */
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, group, size);
+
+    bertlv_header_t header;
+    for(const void *tlv; ( tlv = bertlv_tree_iter_get_next(&iter, &header) ); )
+    {
+        int action = callback(arg, tlv, &header, bertlv_tree_iter_get_depth(&iter));
+        if( action == BERTLV_WALK_STOP ) return BERTLV_OK;
+        if( action == BERTLV_WALK_SKIP ) bertlv_tree_iter_skip(&iter);
+    }
+
+    return bertlv_tree_iter_get_error(&iter);
+}
+//------------------------------------------------------------------------------
+const void* bertlv_find_path(const void *group, size_t size, const bertlv_tag_t *tags, size_t depth)
+{
+    /**
+     * Find a nested TLV element by a path of tags.
+     *
+     * @param group The set of raw data of TLV elements.
+     * @param size  Size of the input data.
+     * @param tags  Tags of each level, from the outermost to the target element.
+     * @param depth Number of tags.
+     * @return The TLV element if found; or
+     *         NULL if not found.
+     *
+     * @remarks Only the constructed elements on the path will be descended into,
+     *          and the first match in pre-order will be returned.
+     */
+    bertlv_path_t path = { .tags = tags, .depth = depth };
+    const void   *tlv  = NULL;
+
+    bertlv_find_paths(group, size, &path, 1, &tlv);
+    return tlv;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_find_paths(const void          *group,
+                         size_t               size,
+                         const bertlv_path_t *paths,
+                         size_t               count,
+                         const void         **results)
+{
+    /**
+     * Resolve a batch of tag paths in one pass.
+     *
+     * @param group   The set of raw data of TLV elements.
+     * @param size    Size of the input data.
+     * @param paths   The paths to be resolved.
+     * @param count   Number of paths.
+     * @param results Receives the element found of each path, or NULL if not found.
+     * @return The number of paths be resolved.
+     *
+     * @remarks Constructed elements will be descended into only if they are
+     *          on the way of some unresolved paths,
+     *          and the walking stops as soon as all paths be resolved.
+     */
+    for(size_t i=0; i<count; ++i)
+        results[i] = NULL;
+
+    size_t resolved = 0;
+
+    bertlv_tag_t ancestors[BERTLV_TREE_DEPTH_MAX];
+
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, group, size);
+
+    bertlv_header_t header;
+    for(const void *tlv;
+        resolved < count && ( tlv = bertlv_tree_iter_get_next(&iter, &header) ); )
+    {
+        unsigned depth = bertlv_tree_iter_get_depth(&iter);
+        ancestors[depth] = header.tag;
+
+        bool descend = false;
+        for(size_t i=0; i<count; ++i)
+        {
+            const bertlv_path_t *path = &paths[i];
+            if( results[i] || path->depth <= depth ) continue;
+            if( memcmp(path->tags, ancestors, ( depth + 1 )*sizeof(bertlv_tag_t)) ) continue;
+
+            if( path->depth == depth + 1 )
+            {
+                results[i] = tlv;
+                ++resolved;
+            }
+            else
+            {
+                descend = true;
+            }
+        }
+
+        if( !descend ) bertlv_tree_iter_skip(&iter);
+    }
+
+    return resolved;
+}
+//------------------------------------------------------------------------------
+static
+bertlv_tag_t bertlv_tag_canonical(bertlv_tag_t tag, unsigned options)
+{
+    // Re-encode the tag number in the fewest bytes,
+    // and numbers less than 31 keep the multi-byte form unless low tags be requested.
+    long num   = bertlv_tag_get_number(tag);
+    int  first = bertlv_tag_get_first_byte(tag);
+
+    if( num < 0x1F && ( first & tag_mask_first ) == tag_mask_first && !( options & BERTLV_DER_LOW_TAGS ) )
+        return ( (bertlv_tag_t)first << 8 ) | num;
+
+    return bertlv_tag_make(bertlv_tag_get_class(tag), bertlv_tag_get_type(tag), num);
+}
+//------------------------------------------------------------------------------
+static
+size_t bertlv_resolve(uint8_t *buf, size_t bufsize, const uint8_t *group, size_t size, bool der, unsigned options)
+{
+    // Copy a group with all lengths be resolved to the shortest definite forms,
+    // and also all tags be re-encoded in the shortest forms if DER be requested.
+    // The input is walked once, and each constructed element reserves a one-byte length field
+    // that be patched on its end like the builder does.
+    // Return size of the output (or the size needed if no buffer), or ZERO if failed.
+    struct
+    {
+        const uint8_t *end;         // End of the payload, or the enclosing end if indefinite.
+        size_t         len_pos;     // Position of the reserved length field in the output.
+        bool           indefinite;
+    } levels[BERTLV_TREE_DEPTH_MAX];
+
+    unsigned       depth = 0;
+    size_t         out   = 0;
+    const uint8_t *pos   = group;
+
+    while( true )
+    {
+        const uint8_t *end   = depth ? levels[depth-1].end : group + size;
+        size_t         avail = end - pos;
+
+        bool closing = false;
+        if( depth && levels[depth-1].indefinite )
+        {
+            if( avail < 2 ) return 0;
+            if( !pos[0] && !pos[1] )
+            {
+                pos += 2;
+                closing = true;
+            }
+        }
+        else if( !avail )
+        {
+            if( !depth ) break;
+            closing = true;
+        }
+
+        if( closing )
+        {
+            --depth;
+
+            size_t len_pos  = levels[depth].len_pos;
+            size_t length   = out - len_pos - 1;
+            size_t len_size = bertlv_len_calc_encode_size(length);
+            if( buf )
+            {
+                if( len_size > 1 )
+                {
+                    if( bufsize - out < len_size - 1 ) return 0;
+                    memmove(buf + len_pos + len_size, buf + len_pos + 1, length);
+                }
+
+                bertlv_len_encode_fixed(buf + len_pos, len_size, length);
+            }
+
+            out += len_size - 1;
+            continue;
+        }
+
+        bertlv_tag_t tag;
+        size_t       tag_size;
+        if( bertlv_tag_decode_s(pos, avail, &tag, &tag_size) ) return 0;
+
+        bool     constructed = bertlv_is_constructed(pos);
+        bool     indefinite  = ( avail > tag_size && pos[tag_size] == len_mask_long_format );
+        uint64_t length      = 0;
+        size_t   len_size    = 1;
+        if( indefinite )
+        {
+            if( !constructed ) return 0;
+        }
+        else
+        {
+            if( bertlv_len_decode64(pos + tag_size, avail - tag_size, &length, &len_size) ) return 0;
+            if( length > avail - tag_size - len_size ) return 0;
+        }
+
+        size_t out_size;
+        if( der )
+        {
+            out_size = bertlv_tag_encode(buf ? buf + out : NULL, bufsize - out, bertlv_tag_canonical(tag, options));
+            if( !out_size ) return 0;
+        }
+        else
+        {
+            out_size = tag_size;
+            if( buf )
+            {
+                if( bufsize - out < tag_size ) return 0;
+                memcpy(buf + out, pos, tag_size);
+            }
+        }
+        out += out_size;
+
+        const uint8_t *value = pos + tag_size + len_size;
+        if( !constructed )
+        {
+            out_size = bertlv_len_encode(buf ? buf + out : NULL, bufsize - out, length);
+            if( !out_size ) return 0;
+            out += out_size;
+
+            if( buf )
+            {
+                if( bufsize - out < length ) return 0;
+                if( length ) memcpy(buf + out, value, length);
+            }
+            out += length;
+
+            pos = value + length;
+            continue;
+        }
+
+        if( depth >= BERTLV_TREE_DEPTH_MAX ) return 0;
+        if( buf && bufsize - out < 1 ) return 0;
+
+        levels[depth].end        = indefinite ? end : value + length;
+        levels[depth].len_pos    = out;
+        levels[depth].indefinite = indefinite;
+        ++depth;
+
+        out += 1;
+        pos  = value;
+    }
+
+    return out;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_resolve_indefinite(void *buf, size_t bufsize, const void *group, size_t size)
+{
+    /**
+     * Copy nested TLV data with all indefinite lengths resolved to definite ones.
+     *
+     * @param buf     A buffer to receive the output data,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @param group   The set of raw data of TLV elements.
+     * @param size    Size of the input data.
+     * @return Size of the output data if succeed; or
+     *         ZERO if the input is malformed or the buffer is not large enough.
+     *
+     * @remarks All length fields will be written in the shortest definite form,
+     *          and end-of-contents be removed.
+     * @remarks The input is parsed once without recursion.
+     *          Payload of a constructed element will be moved once more on its end
+     *          only if its length needs the long form,
+     *          so each byte be moved at most once per enclosing level
+     *          (bounded by ::BERTLV_TREE_DEPTH_MAX).
+     *          The content of the output buffer is undefined if failed.
+     */
+    return bertlv_resolve(buf, bufsize, group, size, false, 0);
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_der_compare(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize)
+{
+    // Compare two encodings as octet strings, the shorter one be padded with zeros.
+    size_t common = ( asize < bsize )?( asize ):( bsize );
+
+    int res = memcmp(a, b, common);
+    if( res ) return res;
+
+    const uint8_t *rest = ( asize < bsize )?( b + common ):( a + common );
+    size_t         left = ( asize < bsize )?( bsize - common ):( asize - common );
+    for(size_t i=0; i<left; ++i)
+    {
+        if( rest[i] ) return ( asize < bsize )?( -1 ):( 1 );
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+int bertlv_der_check(const void *group, size_t size, unsigned options, unsigned *violations)
+{
+    /**
+     * Check if nested TLV data is encoded in the Distinguished Encoding Rules.
+     *
+     * @param group      The set of raw data of TLV elements.
+     * @param size       Size of the input data.
+     * @param options    Combination of ::bertlv_der_option_t flags.
+     * @param violations Receives a combination of ::bertlv_der_violation_t flags,
+     *                   and ZERO means the data is canonical.
+     * @return ::BERTLV_OK if the data be checked completely; or
+     *         one of ::bertlv_error_t values if the data is malformed
+     *         (@a violations contains what be found before the error).
+     *
+     * @remarks All elements are visited in one pass without any memory allocation,
+     *          and members of a SET are compared with their previous sibling only.
+     *          Only the encodings of tags and lengths are checked,
+     *          not the contents of the universal types.
+     */
+    unsigned found = 0;
+
+    const uint8_t *prev    [BERTLV_TREE_DEPTH_MAX] = { NULL };
+    size_t         prevsize[BERTLV_TREE_DEPTH_MAX];
+    bool           in_set  [BERTLV_TREE_DEPTH_MAX] = { false };
+
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, group, size);
+
+    bertlv_header_t header;
+    for(const uint8_t *tlv; ( tlv = bertlv_tree_iter_get_next(&iter, &header) ); )
+    {
+        unsigned depth = bertlv_tree_iter_get_depth(&iter);
+
+        if( header.tag != bertlv_tag_canonical(header.tag, options) )
+            found |= BERTLV_DER_LONG_TAG;
+
+        if( header.indefinite )
+            found |= BERTLV_DER_INDEFINITE;
+        else if( header.len_size != bertlv_len_calc_encode_size(header.length) )
+            found |= BERTLV_DER_LONG_LENGTH;
+
+        if( ( options & BERTLV_DER_CHECK_ORDER ) && depth && in_set[depth-1] && prev[depth] &&
+            bertlv_der_compare(prev[depth], prevsize[depth], tlv, header.total_size) > 0 )
+        {
+            found |= BERTLV_DER_UNORDERED;
+        }
+
+        prev    [depth] = tlv;
+        prevsize[depth] = header.total_size;
+        in_set  [depth] = header.tag == 0x31;
+
+        if( depth + 1 < BERTLV_TREE_DEPTH_MAX ) prev[depth+1] = NULL;
+    }
+
+    *violations = found;
+    return bertlv_tree_iter_get_error(&iter);
+}
+//------------------------------------------------------------------------------
+size_t bertlv_der_canonicalize(void *buf, size_t bufsize, const void *group, size_t size, unsigned options)
+{
+    /**
+     * Copy nested TLV data with all tags and lengths be re-encoded in DER.
+     *
+     * @param buf     A buffer to receive the output data,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @param group   The set of raw data of TLV elements.
+     * @param size    Size of the input data.
+     * @param options Combination of ::bertlv_der_option_t flags,
+     *                and only ::BERTLV_DER_LOW_TAGS affects the output.
+     * @return Size of the output data if succeed; or
+     *         ZERO if the input is malformed or the buffer is not large enough.
+     *
+     * @remarks Tags and lengths be written in the shortest forms,
+     *          and indefinite lengths be resolved.
+     *          Members of SET will not be reordered,
+     *          use ::bertlv_der_check to find that if needed.
+     * @remarks The input is parsed once by the same writer as ::bertlv_resolve_indefinite,
+     *          and payload of a constructed element be moved once more on its end
+     *          only if its length needs the long form.
+     *          So the cost is linear in the input size times the number of such enclosing levels,
+     *          at most ::BERTLV_TREE_DEPTH_MAX.
+     */
+    return bertlv_resolve(buf, bufsize, group, size, true, options);
+}
+//------------------------------------------------------------------------------
+//---- TLV builder -------------------------------------------------------------
+//------------------------------------------------------------------------------
+void bertlv_builder_init(bertlv_builder_t *builder, void *buf, size_t bufsize)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief Constructor.
+     *
+     * @param builder The builder it self.
+     * @param buf     The buffer to be filled by the encoded TLV data.
+     * @param bufsize Size of the output buffer.
+     */
+    builder->buf     = buf;
+    builder->bufsize = bufsize;
+    builder->size    = 0;
+    builder->depth   = 0;
+    builder->failed  = !buf;
+}
+//------------------------------------------------------------------------------
+bool bertlv_builder_begin(bertlv_builder_t *builder, bertlv_tag_t tag, size_t maxlen)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief Begin a constructed element.
+     *
+     * @param builder The builder object.
+     * @param tag     Tag of the element.
+     * @param maxlen  The expected maximum payload size, to decide the size of
+     *                length field be reserved.
+     *                ZERO can be used to reserve the shortest length field, and
+     *                ::BERTLV_LEN_INDEFINITE can be used to encode an indefinite length
+     *                that be terminated by end-of-contents on ::bertlv_builder_end.
+     * @return TRUE if succeed; and FALSE if not.
+     *
+     * @remarks The payload will be moved on ::bertlv_builder_end only if
+     *          the final length needs a longer length field than the reserved one.
+     *          And if the final length needs a shorter field than the reserved one,
+     *          the length will be padded with leading zeros in long format
+     *          (valid in BER but not in DER) to avoid moving payload.
+     */
+    if( builder->failed ) return false;
+
+    do
+    {
+        if( builder->depth >= BERTLV_TREE_DEPTH_MAX ) break;
+
+        size_t tag_size = bertlv_tag_encode(builder->buf + builder->size,
+                                            builder->bufsize - builder->size,
+                                            tag);
+        if( !tag_size ) break;
+
+        size_t len_pos  = builder->size + tag_size;
+        size_t len_size = ( maxlen == BERTLV_LEN_INDEFINITE )?( 1 ):( bertlv_len_calc_encode_size(maxlen) );
+        if( builder->bufsize - len_pos < len_size ) break;
+
+        // A reserved size of ZERO marks the indefinite length.
+        if( maxlen == BERTLV_LEN_INDEFINITE ) builder->buf[len_pos] = len_mask_long_format;
+
+        builder->len_pos [builder->depth] = len_pos;
+        builder->len_size[builder->depth] = ( maxlen == BERTLV_LEN_INDEFINITE )?( 0 ):( len_size );
+        ++builder->depth;
+
+        builder->size = len_pos + len_size;
+
+        return true;
+    } while(false);
+
+    builder->failed = true;
+    return false;
+}
+//------------------------------------------------------------------------------
+bool bertlv_builder_end(bertlv_builder_t *builder)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief End the constructed element that was begun last.
+     *
+     * @param builder The builder object.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    if( builder->failed ) return false;
+
+    do
+    {
+        if( !builder->depth ) break;
+        --builder->depth;
+
+        size_t len_pos  = builder->len_pos [builder->depth];
+        size_t reserved = builder->len_size[builder->depth];
+
+        if( !reserved )
+        {
+            if( builder->bufsize - builder->size < 2 ) break;
+
+            builder->buf[builder->size++] = 0;
+            builder->buf[builder->size++] = 0;
+            return true;
+        }
+
+        size_t payload  = len_pos + reserved;
+        size_t length   = builder->size - payload;
+
+        size_t len_size = bertlv_len_calc_encode_size(length);
+        if( len_size > reserved )
+        {
+            size_t grow = len_size - reserved;
+            if( builder->bufsize - builder->size < grow ) break;
+
+            memmove(builder->buf + payload + grow, builder->buf + payload, length);
+            builder->size += grow;
+        }
+        else
+        {
+            len_size = reserved;
+        }
+
+        bertlv_len_encode_fixed(builder->buf + len_pos, len_size, length);
+
+        return true;
+    } while(false);
+
+    builder->failed = true;
+    return false;
+}
+//------------------------------------------------------------------------------
+bool bertlv_builder_append(bertlv_builder_t *builder, bertlv_tag_t tag, const void *data, size_t size)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief Append a primitive element to the current level.
+     *
+     * @param builder The builder object.
+     * @param tag     Tag of the element.
+     * @param data    Payload data of the element.
+     * @param size    Payload size of the element.
+     * @return TRUE if succeed; and FALSE if not.
+     *
+     * @remarks Pre-encoded TLV data can be appended by ::bertlv_builder_alloc
+     *          with a copy, and a constructed element can also be appended by this
+     *          function if its payload is already encoded.
+     */
+    void *pos = bertlv_builder_alloc(builder, tag, size);
+    if( !pos ) return false;
+
+    if( size ) memcpy(pos, data, size);
+    return true;
+}
+//------------------------------------------------------------------------------
+void* bertlv_builder_alloc(bertlv_builder_t *builder, bertlv_tag_t tag, size_t size)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief Append a primitive element and let the caller fill its payload.
+     *
+     * @param builder The builder object.
+     * @param tag     Tag of the element.
+     * @param size    Payload size of the element.
+     * @return A pointer to the payload area to be filled if succeed; or
+     *         NULL if failed.
+     */
+    if( builder->failed ) return NULL;
+
+    do
+    {
+        uint8_t *pos  = builder->buf + builder->size;
+        size_t   rest = builder->bufsize - builder->size;
+
+        size_t tag_size = bertlv_tag_encode(pos, rest, tag);
+        if( !tag_size ) break;
+        pos  += tag_size;
+        rest -= tag_size;
+
+        size_t len_size = bertlv_len_encode(pos, rest, size);
+        if( !len_size ) break;
+        pos  += len_size;
+        rest -= len_size;
+
+        if( rest < size ) break;
+
+        builder->size += tag_size + len_size + size;
+        return pos;
+    } while(false);
+
+    builder->failed = true;
+    return NULL;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_builder_finish(const bertlv_builder_t *builder)
+{
+    /**
+     * @memberof bertlv_builder_t
+     * @brief Get the result of building.
+     *
+     * @param builder The builder object.
+     * @return Size of the encoded data in the output buffer if succeed; or
+     *         ZERO if any operation failed or some constructed elements are not ended.
+     */
+    return ( builder->failed || builder->depth )?( 0 ):( builder->size );
+}
+//------------------------------------------------------------------------------
+//---- TLV reverse writer ------------------------------------------------------
+//------------------------------------------------------------------------------
+static
+bool bertlv_rwriter_prepend_header(bertlv_rwriter_t *writer, bertlv_tag_t tag, size_t length)
+{
+    size_t tag_size = bertlv_tag_encode(NULL, 0, tag);
+    size_t len_size = bertlv_len_encode(NULL, 0, length);
+    if( !tag_size || writer->pos < tag_size + len_size ) return false;
+
+    writer->pos -= len_size;
+    bertlv_len_encode(writer->buf + writer->pos, len_size, length);
+
+    writer->pos -= tag_size;
+    bertlv_tag_encode(writer->buf + writer->pos, tag_size, tag);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void bertlv_rwriter_init(bertlv_rwriter_t *writer, void *buf, size_t bufsize)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Constructor.
+     *
+     * @param writer  The writer it self.
+     * @param buf     The buffer to be filled by the encoded TLV data.
+     * @param bufsize Size of the output buffer.
+     */
+    writer->buf     = buf;
+    writer->bufsize = bufsize;
+    writer->pos     = bufsize;
+    writer->depth   = 0;
+    writer->failed  = !buf;
+}
+//------------------------------------------------------------------------------
+bool bertlv_rwriter_open(bertlv_rwriter_t *writer)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Start the payload of a constructed element.
+     *
+     * @param writer The writer object.
+     * @return TRUE if succeed; and FALSE if not.
+     *
+     * @remarks The children written after this call
+     *          (in reverse order) will be the payload of the element,
+     *          and the tag of the element will be given on ::bertlv_rwriter_close.
+     */
+    if( writer->failed ) return false;
+
+    if( writer->depth >= BERTLV_TREE_DEPTH_MAX )
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->ends[writer->depth++] = writer->pos;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool bertlv_rwriter_close(bertlv_rwriter_t *writer, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Prepend the header of the constructed element that was opened last.
+     *
+     * @param writer The writer object.
+     * @param tag    Tag of the element.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    if( writer->failed ) return false;
+
+    if( !writer->depth ||
+        !bertlv_rwriter_prepend_header(writer,
+                                       tag,
+                                       writer->ends[writer->depth-1] - writer->pos) )
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    --writer->depth;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool bertlv_rwriter_put(bertlv_rwriter_t *writer, bertlv_tag_t tag, const void *data, size_t size)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Prepend a primitive element.
+     *
+     * @param writer The writer object.
+     * @param tag    Tag of the element.
+     * @param data   Payload data of the element.
+     * @param size   Payload size of the element.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    void *pos = bertlv_rwriter_alloc(writer, tag, size);
+    if( !pos ) return false;
+
+    if( size ) memcpy(pos, data, size);
+    return true;
+}
+//------------------------------------------------------------------------------
+void* bertlv_rwriter_alloc(bertlv_rwriter_t *writer, bertlv_tag_t tag, size_t size)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Prepend a primitive element and let the caller fill its payload.
+     *
+     * @param writer The writer object.
+     * @param tag    Tag of the element.
+     * @param size   Payload size of the element.
+     * @return A pointer to the payload area to be filled if succeed; or
+     *         NULL if failed.
+     */
+    if( writer->failed ) return NULL;
+
+    if( writer->pos < size )
+    {
+        writer->failed = true;
+        return NULL;
+    }
+
+    writer->pos -= size;
+    uint8_t *value = writer->buf + writer->pos;
+
+    if( !bertlv_rwriter_prepend_header(writer, tag, size) )
+    {
+        writer->failed = true;
+        return NULL;
+    }
+
+    return value;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_rwriter_finish(const bertlv_rwriter_t *writer, size_t *size)
+{
+    /**
+     * @memberof bertlv_rwriter_t
+     * @brief Get the result of writing.
+     *
+     * @param writer The writer object.
+     * @param size   Receives size of the encoded data.
+     * @return The start of the encoded data inside the output buffer if succeed; or
+     *         NULL if any operation failed or some constructed elements are not closed.
+     */
+    if( writer->failed || writer->depth )
+    {
+        *size = 0;
+        return NULL;
+    }
+
+    *size = writer->bufsize - writer->pos;
+    return writer->buf + writer->pos;
+}
+//------------------------------------------------------------------------------
+//---- TLV in-place editing ----------------------------------------------------
+//------------------------------------------------------------------------------
+typedef struct bertlv_edit_level_t
+{
+    size_t len_pos;
+    size_t len_size;
+    size_t length;
+    size_t new_len_size;
+    bool   indefinite;
+} bertlv_edit_level_t;
+//------------------------------------------------------------------------------
+static
+int bertlv_edit_locate(const uint8_t       *buf,
+                       size_t               size,
+                       const bertlv_tag_t  *tags,
+                       size_t               depth,
+                       bertlv_edit_level_t *levels,
+                       bertlv_header_t     *target)
+{
+    // Find the element in the same way as bertlv_find_path,
+    // and record the length fields of every element on the path.
+    if( !depth ) return BERTLV_ERR_MISSING_FIELD;
+    if( depth > BERTLV_TREE_DEPTH_MAX ) return BERTLV_ERR_TOO_DEEP;
+
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, buf, size);
+
+    bertlv_header_t header;
+    for(const uint8_t *tlv; ( tlv = bertlv_tree_iter_get_next(&iter, &header) ); )
+    {
+        unsigned level = bertlv_tree_iter_get_depth(&iter);
+        if( header.tag != tags[level] )
+        {
+            bertlv_tree_iter_skip(&iter);
+            continue;
+        }
+
+        levels[level].len_pos    = tlv - buf + header.tag_size;
+        levels[level].len_size   = header.len_size;
+        levels[level].length     = header.length;
+        levels[level].indefinite = header.indefinite;
+
+        if( level + 1 == depth )
+        {
+            *target = header;
+            return BERTLV_OK;
+        }
+    }
+
+    int err = bertlv_tree_iter_get_error(&iter);
+    return err ? err : BERTLV_ERR_MISSING_FIELD;
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_edit_splice(uint8_t             *buf,
+                       size_t              *size,
+                       size_t               bufsize,
+                       bertlv_edit_level_t *levels,
+                       size_t               count,
+                       size_t               pos,
+                       size_t               oldsize,
+                       const uint8_t       *head,
+                       size_t               headsize,
+                       const void          *data,
+                       size_t               datasize)
+{
+    // Replace the range [pos, pos+oldsize) by the head and the data,
+    // and re-encode the length fields of all levels (which enclose the range)
+    // in the minimal form if their lengths be changed.
+    // Indefinite lengths keep unchanged, but their fields may be moved.
+    // Every byte after the first changed field is moved at most once.
+    if( headsize + datasize > bufsize ) return BERTLV_ERR_NO_SPACE;
+
+    ptrdiff_t delta = (ptrdiff_t)( headsize + datasize ) - (ptrdiff_t)oldsize;
+    for(size_t i=count; i--; )
+    {
+        bertlv_edit_level_t *level = &levels[i];
+
+        level->new_len_size = level->len_size;
+        if( level->indefinite || !delta ) continue;
+
+        level->length       += delta;
+        level->new_len_size  = bertlv_len_calc_encode_size(level->length);
+
+        delta += (ptrdiff_t)level->new_len_size - (ptrdiff_t)level->len_size;
+    }
+
+    if( delta > 0 && bufsize - *size < (size_t)delta ) return BERTLV_ERR_NO_SPACE;
+
+    // The shift of the segment after each changed field, and the segment after the content.
+    ptrdiff_t shifts[BERTLV_TREE_DEPTH_MAX+1];
+    ptrdiff_t shift = 0;
+    for(size_t i=0; i<count; ++i)
+    {
+        shift += (ptrdiff_t)levels[i].new_len_size - (ptrdiff_t)levels[i].len_size;
+        shifts[i] = shift;
+    }
+    shifts[count] = delta;
+
+    // Move the segments that go forward from the end,
+    // and then the segments that go backward from the start,
+    // so that no segment overwrites another one that has not been moved.
+    for(size_t n=0; n<2*(count+1); ++n)
+    {
+        bool   forward = n <= count;
+        size_t i       = forward ? count - n : n - count - 1;
+        if( forward ? shifts[i] <= 0 : shifts[i] >= 0 ) continue;
+
+        size_t start = ( i < count ) ? levels[i].len_pos + levels[i].len_size : pos + oldsize;
+        size_t end   = ( i + 1 < count ) ? levels[i+1].len_pos : ( i < count ) ? pos : *size;
+        if( start >= end ) continue;
+
+        memmove(buf + start + shifts[i], buf + start, end - start);
+    }
+
+    // Write the length fields and the new content on their new positions.
+    // The indefinite marks are rewritten too, because the fields are not moved with the segments.
+    for(size_t i=0; i<count; ++i)
+    {
+        size_t at = levels[i].len_pos + ( i ? shifts[i-1] : 0 );
+        if( levels[i].indefinite )
+            buf[at] = len_mask_long_format;
+        else
+            bertlv_len_encode_fixed(buf + at, levels[i].new_len_size, levels[i].length);
+    }
+
+    uint8_t *dest = buf + pos + ( count ? shifts[count-1] : 0 );
+    if( headsize ) memcpy(dest, head, headsize);
+    if( datasize ) memmove(dest + headsize, data, datasize);
+
+    *size += delta;
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+int bertlv_edit_replace(void               *buf,
+                        size_t             *size,
+                        size_t              bufsize,
+                        const bertlv_tag_t *tags,
+                        size_t              depth,
+                        const void         *data,
+                        size_t              datasize)
+{
+    /**
+     * Replace the payload of a nested TLV element in place.
+     *
+     * @param buf      The buffer that contains the TLV data.
+     * @param size     Size of the TLV data, and receives the new size.
+     * @param bufsize  Size of the buffer, the data may grow up to it.
+     * @param tags     Path to the element, see ::bertlv_find_path.
+     * @param depth    Number of tags in the path.
+     * @param data     The new payload, it must not overlap the buffer.
+     * @param datasize Size of the new payload.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_MISSING_FIELD if the element is not found; or
+     *         ::BERTLV_ERR_NO_SPACE if the buffer is too small (the data keeps unchanged); or
+     *         other ::bertlv_error_t values if the data is malformed.
+     *
+     * @remarks Only the data after the payload will be moved,
+     *          and nothing be moved if the payload size is not changed.
+     *          Length fields of the element and its ancestors be re-encoded
+     *          in the minimal form if their lengths be changed.
+     */
+    bertlv_edit_level_t levels[BERTLV_TREE_DEPTH_MAX];
+    bertlv_header_t     target;
+
+    int err = bertlv_edit_locate(buf, *size, tags, depth, levels, &target);
+    if( err ) return err;
+
+    size_t pos = (const uint8_t*)target.value - (const uint8_t*)buf;
+    return bertlv_edit_splice(buf, size, bufsize, levels, depth, pos, target.length, NULL, 0, data, datasize);
+}
+//------------------------------------------------------------------------------
+int bertlv_edit_insert(void               *buf,
+                       size_t             *size,
+                       size_t              bufsize,
+                       const bertlv_tag_t *tags,
+                       size_t              depth,
+                       bertlv_tag_t        tag,
+                       const void         *data,
+                       size_t              datasize)
+{
+    /**
+     * Insert a TLV element as the last child of a constructed element in place.
+     *
+     * @param buf      The buffer that contains the TLV data.
+     * @param size     Size of the TLV data, and receives the new size.
+     * @param bufsize  Size of the buffer, the data may grow up to it.
+     * @param tags     Path to the parent element, see ::bertlv_find_path.
+     * @param depth    Number of tags in the path,
+     *                 and ZERO to append the element to the top level.
+     * @param tag      Tag of the new element.
+     * @param data     Payload of the new element, it must not overlap the buffer.
+     * @param datasize Size of the payload.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_MISSING_FIELD if the parent is not found; or
+     *         ::BERTLV_ERR_INVALID_FIELD if the parent is not constructed or the tag is invalid; or
+     *         ::BERTLV_ERR_NO_SPACE if the buffer is too small (the data keeps unchanged); or
+     *         other ::bertlv_error_t values if the data is malformed.
+     */
+    if( !bertlv_tag_is_valid(tag) ) return BERTLV_ERR_INVALID_FIELD;
+
+    uint8_t head[sizeof(bertlv_tag_t) + 1 + sizeof(size_t)];
+    size_t  tagsize = bertlv_tag_encode(head, sizeof(head), tag);
+    if( !tagsize ) return BERTLV_ERR_INVALID_FIELD;
+    size_t  headsize = tagsize + bertlv_len_encode(head + tagsize, sizeof(head) - tagsize, datasize);
+
+    if( !depth )
+        return bertlv_edit_splice(buf, size, bufsize, NULL, 0, *size, 0, head, headsize, data, datasize);
+
+    bertlv_edit_level_t levels[BERTLV_TREE_DEPTH_MAX];
+    bertlv_header_t     parent;
+
+    int err = bertlv_edit_locate(buf, *size, tags, depth, levels, &parent);
+    if( err ) return err;
+    const uint8_t *tlv = (const uint8_t*)parent.value - parent.len_size - parent.tag_size;
+    if( !bertlv_is_constructed(tlv) ) return BERTLV_ERR_INVALID_FIELD;
+
+    size_t pos = (const uint8_t*)parent.value + parent.length - (const uint8_t*)buf;
+    return bertlv_edit_splice(buf, size, bufsize, levels, depth, pos, 0, head, headsize, data, datasize);
+}
+//------------------------------------------------------------------------------
+int bertlv_edit_delete(void *buf, size_t *size, const bertlv_tag_t *tags, size_t depth)
+{
+    /**
+     * Delete a nested TLV element in place.
+     *
+     * @param buf   The buffer that contains the TLV data.
+     * @param size  Size of the TLV data, and receives the new size.
+     * @param tags  Path to the element, see ::bertlv_find_path.
+     * @param depth Number of tags in the path.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_MISSING_FIELD if the element is not found; or
+     *         other ::bertlv_error_t values if the data is malformed.
+     */
+    bertlv_edit_level_t levels[BERTLV_TREE_DEPTH_MAX];
+    bertlv_header_t     target;
+
+    int err = bertlv_edit_locate(buf, *size, tags, depth, levels, &target);
+    if( err ) return err;
+
+    size_t pos = (const uint8_t*)target.value - target.len_size - target.tag_size - (const uint8_t*)buf;
+    return bertlv_edit_splice(buf, size, *size, levels, depth - 1, pos, target.total_size, NULL, 0, NULL, 0);
+}
+//------------------------------------------------------------------------------
+//---- Statistics --------------------------------------------------------------
+//------------------------------------------------------------------------------
+#ifdef BERTLV_STATS
+
+bertlv_stats_t bertlv_stats_counters;
+
+//------------------------------------------------------------------------------
+void bertlv_stats_get(bertlv_stats_t *stats)
+{
+    /**
+     * Get a snapshot of the parsing statistics.
+     *
+     * @param stats Receives the statistics.
+     *
+     * @remarks Counters are updated atomically, but the snapshot is not taken atomically as a whole.
+     */
+    stats->elements  = __atomic_load_n(&bertlv_stats_counters.elements, __ATOMIC_RELAXED);
+    stats->bytes     = __atomic_load_n(&bertlv_stats_counters.bytes, __ATOMIC_RELAXED);
+    stats->max_depth = __atomic_load_n(&bertlv_stats_counters.max_depth, __ATOMIC_RELAXED);
+
+    for(size_t i=0; i<BERTLV_STATS_ERRORS; ++i)
+        stats->failures[i] = __atomic_load_n(&bertlv_stats_counters.failures[i], __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+void bertlv_stats_reset(void)
+{
+    /**
+     * Reset all statistics to zero.
+     */
+    __atomic_store_n(&bertlv_stats_counters.elements, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&bertlv_stats_counters.bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&bertlv_stats_counters.max_depth, 0, __ATOMIC_RELAXED);
+
+    for(size_t i=0; i<BERTLV_STATS_ERRORS; ++i)
+        __atomic_store_n(&bertlv_stats_counters.failures[i], 0, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+#endif
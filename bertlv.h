@@ -17,6 +17,34 @@
 extern "C" {
 #endif
 
+/**
+ * @name Error Codes
+ * @{
+ */
+
+/**
+ * Error codes of the size-aware (bounds-checked) parsing functions.
+ */
+enum bertlv_error_t
+{
+    BERTLV_OK                   = 0,    ///< No error.
+    BERTLV_ERR_TRUNCATED        = 1,    ///< The tag or length field runs past the end of the input.
+    BERTLV_ERR_NULL_TAG         = 2,    ///< The first tag byte is zero (padding or end-of-contents).
+    BERTLV_ERR_TAG_TOO_LONG     = 3,    ///< The tag is wider than ::bertlv_tag_t.
+    BERTLV_ERR_BAD_LENGTH       = 4,    ///< The length field has a reserved or unsupported form.
+    BERTLV_ERR_LENGTH_TOO_LONG  = 5,    ///< The length is wider than `uint64_t`, or the total size overflows.
+    BERTLV_ERR_OVERRUN          = 6,    ///< The payload runs past the end of the input.
+    BERTLV_ERR_TOO_DEEP         = 7,    ///< Constructed elements are nested deeper than ::BERTLV_TREE_DEPTH_MAX.
+    BERTLV_ERR_ABORTED          = 8,    ///< The processing was aborted by an user callback.
+    BERTLV_ERR_MISSING_FIELD    = 9,    ///< A required element is not found.
+    BERTLV_ERR_INVALID_FIELD    = 10,   ///< An element does not meet its expected format.
+    BERTLV_ERR_NO_SPACE         = 11,   ///< The output buffer or memory arena is too small.
+};
+
+/**
+ * @}
+ */
+
 /**
  * @name Tag Properties
  * @{
@@ -58,12 +86,127 @@ typedef unsigned long bertlv_tag_t;
 
 bertlv_tag_t bertlv_tag_make(int cla, int type, long num);
 
+/**
+ * Compile-time version of ::bertlv_tag_make,
+ * for tag numbers less than 2^21 (tags up to four bytes).
+ */
+#define BERTLV_TAG_MAKE(cla, type, num) \
+    ( (bertlv_tag_t)( ( ( (cla) & 0x03 ) << 6 ) | ( ( (type) & 0x01 ) << 5 ) ) << \
+        ( (num) < 0x1F ? 0 : (num) < 0x80 ? 8 : (num) < 0x4000 ? 16 : 24 ) | \
+      ( (num) < 0x1F ? (bertlv_tag_t)(num) : \
+        (num) < 0x80 ? ( 0x1FUL << 8 ) | (bertlv_tag_t)(num) : \
+        (num) < 0x4000 ? ( 0x1FUL << 16 ) | \
+                         ( ( 0x80UL | ( (num) >> 7 ) ) << 8 ) | \
+                         ( (bertlv_tag_t)(num) & 0x7F ) : \
+        ( 0x1FUL << 24 ) | \
+        ( ( 0x80UL | ( ( (num) >> 14 ) & 0x7F ) ) << 16 ) | \
+        ( ( 0x80UL | ( ( (num) >> 7 ) & 0x7F ) ) << 8 ) | \
+        ( (bertlv_tag_t)(num) & 0x7F ) ) )
+
+/**
+ * Compile-time calculation of the encoded size of a tag, for tags up to four bytes.
+ */
+#define BERTLV_TAG_SIZE(tag) \
+    ( !(tag) ? 0 : (tag) <= 0xFFUL ? 1 : (tag) <= 0xFFFFUL ? 2 : (tag) <= 0xFFFFFFUL ? 3 : 4 )
+
+size_t bertlv_tag_encode(void *buf, size_t bufsize, bertlv_tag_t tag);
+
 bool bertlv_tag_is_valid(bertlv_tag_t tag);
 
 int  bertlv_tag_get_class (bertlv_tag_t tag);
 int  bertlv_tag_get_type  (bertlv_tag_t tag);
 long bertlv_tag_get_number(bertlv_tag_t tag);
 
+/*
+ * Inline versions of the tag property functions,
+ * they give the same results as the normal versions,
+ * and can be folded by the compiler for constant tags.
+ */
+
+static inline
+unsigned bertlv_tag_get_size_inline(bertlv_tag_t tag)
+{
+    /**
+     * Get the number of bytes of a tag.
+     */
+    unsigned size = 0;
+    for(; tag; tag >>= 8)
+        ++size;
+
+    return size;
+}
+
+static inline
+uint8_t bertlv_tag_get_first_byte_inline(bertlv_tag_t tag)
+{
+    /**
+     * Get the first (most significant) byte of a tag.
+     */
+    while( tag > 0xFF )
+        tag >>= 8;
+
+    return tag;
+}
+
+static inline
+bool bertlv_tag_is_valid_inline(bertlv_tag_t tag)
+{
+    /**
+     * Inline version of ::bertlv_tag_is_valid.
+     */
+    unsigned size = bertlv_tag_get_size_inline(tag);
+    if( !size ) return false;
+
+    if( ( bertlv_tag_get_first_byte_inline(tag) & 0x1F ) != 0x1F ) return size == 1;
+    if( size < 2 ) return false;
+
+    // All subsequent bytes except the last one must have the "more" bit.
+    if( tag & 0x80 ) return false;
+    for(unsigned i=1; i<size-1; ++i)
+    {
+        if( !( ( tag >> 8*i ) & 0x80 ) ) return false;
+    }
+
+    return true;
+}
+
+static inline
+int bertlv_tag_get_class_inline(bertlv_tag_t tag)
+{
+    /**
+     * Inline version of ::bertlv_tag_get_class.
+     */
+    return bertlv_tag_get_first_byte_inline(tag) >> 6;
+}
+
+static inline
+int bertlv_tag_get_type_inline(bertlv_tag_t tag)
+{
+    /**
+     * Inline version of ::bertlv_tag_get_type.
+     */
+    return ( bertlv_tag_get_first_byte_inline(tag) >> 5 ) & 0x01;
+}
+
+static inline
+long bertlv_tag_get_number_inline(bertlv_tag_t tag)
+{
+    /**
+     * Inline version of ::bertlv_tag_get_number.
+     */
+    uint8_t first = bertlv_tag_get_first_byte_inline(tag);
+    if( ( first & 0x1F ) != 0x1F ) return first & 0x1F;
+
+    long num = 0;
+    for(int i = bertlv_tag_get_size_inline(tag) - 2; i >= 0; --i)
+    {
+        num <<= 7;
+        num |= ( tag >> 8*i ) & 0x7F;
+    }
+
+    return num;
+}
+
 /**
  * @}
  */
@@ -73,13 +216,77 @@ long bertlv_tag_get_number(bertlv_tag_t tag);
  * @{
  */
 
+size_t bertlv_len_encode(void *buf, size_t bufsize, size_t length);
+size_t bertlv_len_encode64(void *buf, size_t bufsize, uint64_t length);
+int    bertlv_len_decode64(const void *data, size_t size, uint64_t *length, size_t *lensize);
 size_t bertlv_encode(void *buf, size_t bufsize, bertlv_tag_t tag, const void *data, size_t size);
 
+/**
+ * Compile-time calculation of the encoded size of a length field,
+ * for lengths less than 2^32.
+ */
+#define BERTLV_LEN_SIZE(len) \
+    ( (len) <= 0x7FUL ? 1 : (len) <= 0xFFUL ? 2 : (len) <= 0xFFFFUL ? 3 : (len) <= 0xFFFFFFUL ? 4 : 5 )
+
+/**
+ * Compile-time calculation of the encoded size of a TLV element.
+ */
+#define BERTLV_TOTAL_SIZE(tag, len) ( BERTLV_TAG_SIZE(tag) + BERTLV_LEN_SIZE(len) + (len) )
+
 bertlv_tag_t bertlv_get_tag       (const void *tlv);
 size_t       bertlv_get_length    (const void *tlv);
 const void*  bertlv_get_value     (const void *tlv);
 size_t       bertlv_get_total_size(const void *tlv);
 
+/**
+ * @}
+ */
+
+/**
+ * @name TLV Header
+ * @{
+ */
+
+/**
+ * Header information of a TLV element, be decoded in one pass.
+ */
+typedef struct bertlv_header_t
+{
+    bertlv_tag_t tag;           ///< Tag value.
+    size_t       tag_size;      ///< Size of the tag field.
+    size_t       length;        ///< Size of the payload data.
+    size_t       len_size;      ///< Size of the length field.
+    const void  *value;         ///< The payload data.
+    size_t       total_size;    ///< Size of the whole TLV element (including the end-of-contents if any).
+    bool         indefinite;    ///< If the length is indefinite, and the payload is followed by end-of-contents.
+} bertlv_header_t;
+
+size_t bertlv_decode_header(const void *tlv, bertlv_header_t *header);
+int    bertlv_decode_header_s(const void *tlv, size_t size, bertlv_header_t *header);
+
+/**
+ * Header information of a TLV element with 64-bit sizes.
+ * @details It describes elements which may be larger than the memory,
+ *          such as the ones of a large file or stream,
+ *          and also on platforms that `size_t` is 32-bit.
+ */
+typedef struct bertlv_header64_t
+{
+    bertlv_tag_t tag;           ///< Tag value.
+    size_t       tag_size;      ///< Size of the tag field.
+    uint64_t     length;        ///< Size of the payload data (ZERO if indefinite).
+    size_t       len_size;      ///< Size of the length field.
+    uint64_t     total_size;    ///< Size of the whole TLV element (ZERO if indefinite).
+    bool         indefinite;    ///< If the length is indefinite.
+} bertlv_header64_t;
+
+int    bertlv_decode_header64(const void *tlv, size_t size, bertlv_header64_t *header);
+
+bertlv_tag_t bertlv_get_tag_s       (const void *tlv, size_t size);
+size_t       bertlv_get_length_s    (const void *tlv, size_t size);
+const void*  bertlv_get_value_s     (const void *tlv, size_t size);
+size_t       bertlv_get_total_size_s(const void *tlv, size_t size);
+
 /**
  * @}
  */
@@ -92,6 +299,7 @@ typedef struct bertlv_iter_t
 {
     const uint8_t *pos;
     size_t         size;
+    int            err;
 } bertlv_iter_t;
 
 static inline
@@ -104,12 +312,31 @@ void bertlv_iter_init(bertlv_iter_t *iter, const void *group, size_t size)
      * @param iter  The iterator it self.
      * @param group A set of data of TLV elements.
      * @param size  Size of the input data.
+     *
+     * @remarks The iterator never reads past @a size bytes of @a group,
+     *          so it can be used on untrusted input directly.
      */
-    iter->pos  = group;
+    iter->pos  = (const uint8_t*) group;
     iter->size = size;
+    iter->err  = BERTLV_OK;
+}
+
+static inline
+int bertlv_iter_get_error(const bertlv_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_iter_t
+     * @brief Get the reason of why the iteration stopped.
+     *
+     * @param iter The iterator object.
+     * @return ::BERTLV_OK if no error occurred (the data was consumed completely); or
+     *         one of ::bertlv_error_t values to describe the malformed element.
+     */
+    return iter->err;
 }
 
 const void* bertlv_iter_get_next(bertlv_iter_t *iter);
+const void* bertlv_iter_get_next_header(bertlv_iter_t *iter, bertlv_header_t *header);
 
 /**
  * @name TLV Group
@@ -118,12 +345,259 @@ const void* bertlv_iter_get_next(bertlv_iter_t *iter);
 
 unsigned    bertlv_grp_count(const void *group, size_t size);
 const void* bertlv_grp_find(const void *group, size_t size, bertlv_tag_t tag);
+size_t      bertlv_grp_find_many(const void         *group,
+                                 size_t              size,
+                                 const bertlv_tag_t *tags,
+                                 size_t              ntags,
+                                 const void        **out);
 size_t      bertlv_grp_calc_total_size(const void *group, size_t size);
+size_t      bertlv_grp_scan(const void *group, size_t size, size_t *offsets, size_t capacity);
 
 /**
  * @}
  */
 
+/**
+ * @name TLV Tree
+ * @{
+ */
+
+/**
+ * Maximum nesting depth of constructed elements that the tree functions can handle.
+ */
+#define BERTLV_TREE_DEPTH_MAX 16
+
+/**
+ * @class bertlv_tree_iter_t
+ * @brief Pre-order iterator of nested TLV elements.
+ * @details Constructed elements will be descended into automatically,
+ *          and it uses an explicit stack (no recursion) with bounded depth.
+ *          In lazy mode (see ::bertlv_tree_iter_init_lazy), constructed elements
+ *          will be descended into only if the caller enters them,
+ *          and the others be jumped over by their length without decoding their children.
+ */
+typedef struct bertlv_tree_iter_t
+{
+    bertlv_iter_t  levels[BERTLV_TREE_DEPTH_MAX];
+    unsigned       depth;
+    const uint8_t *child;
+    size_t         child_size;
+    bool           lazy;
+    bool           entered;
+    int            err;
+} bertlv_tree_iter_t;
+
+void        bertlv_tree_iter_init(bertlv_tree_iter_t *iter, const void *group, size_t size);
+void        bertlv_tree_iter_init_lazy(bertlv_tree_iter_t *iter, const void *group, size_t size);
+const void* bertlv_tree_iter_get_next(bertlv_tree_iter_t *iter, bertlv_header_t *header);
+void        bertlv_tree_iter_skip(bertlv_tree_iter_t *iter);
+bool        bertlv_tree_iter_enter(bertlv_tree_iter_t *iter);
+void        bertlv_tree_iter_leave(bertlv_tree_iter_t *iter);
+
+static inline
+unsigned bertlv_tree_iter_get_depth(const bertlv_tree_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Get the nesting depth of the last element returned.
+     *
+     * @param iter The iterator object.
+     * @return The depth, and elements of the top level group have depth ZERO.
+     */
+    return iter->depth;
+}
+
+static inline
+int bertlv_tree_iter_get_error(const bertlv_tree_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_tree_iter_t
+     * @brief Get the reason of why the iteration stopped.
+     *
+     * @param iter The iterator object.
+     * @return ::BERTLV_OK if no error occurred; or
+     *         one of ::bertlv_error_t values to describe the error.
+     */
+    return iter->err;
+}
+
+/**
+ * Return values of ::bertlv_walk_cb_t.
+ */
+enum bertlv_walk_action_t
+{
+    BERTLV_WALK_CONTINUE    = 0,    ///< Continue, and descend into the element if it is constructed.
+    BERTLV_WALK_SKIP        = 1,    ///< Continue, but do not descend into the element.
+    BERTLV_WALK_STOP        = 2,    ///< Stop walking.
+};
+
+/**
+ * Callback of ::bertlv_walk.
+ *
+ * @param arg    The user argument.
+ * @param tlv    The TLV element.
+ * @param header Header of the TLV element.
+ * @param depth  Nesting depth of the TLV element.
+ * @return One of ::bertlv_walk_action_t values.
+ */
+typedef int(*bertlv_walk_cb_t)(void *arg, const void *tlv, const bertlv_header_t *header, unsigned depth);
+
+int bertlv_walk(const void *group, size_t size, bertlv_walk_cb_t callback, void *arg);
+
+/**
+ * Path of nested tags, from the outermost to the target element.
+ */
+typedef struct bertlv_path_t
+{
+    const bertlv_tag_t *tags;   ///< Tags of each level.
+    size_t              depth;  ///< Number of tags.
+} bertlv_path_t;
+
+const void* bertlv_find_path(const void *group, size_t size, const bertlv_tag_t *tags, size_t depth);
+size_t      bertlv_find_paths(const void          *group,
+                              size_t               size,
+                              const bertlv_path_t *paths,
+                              size_t               count,
+                              const void         **results);
+
+size_t bertlv_resolve_indefinite(void *buf, size_t bufsize, const void *group, size_t size);
+
+/**
+ * Options of ::bertlv_der_check and ::bertlv_der_canonicalize.
+ */
+enum bertlv_der_option_t
+{
+    BERTLV_DER_CHECK_ORDER  = 0x01, ///< Check if members of SET (tag 0x31) are sorted by their encodings.
+    BERTLV_DER_LOW_TAGS     = 0x02, ///< Tag numbers less than 31 must be in the single byte form
+                                    ///< (not used by default, because EMV uses tags like BF0C).
+};
+
+/**
+ * Violations of DER that be reported by ::bertlv_der_check.
+ */
+enum bertlv_der_violation_t
+{
+    BERTLV_DER_LONG_TAG     = 0x01, ///< A tag is not encoded in the shortest form.
+    BERTLV_DER_LONG_LENGTH  = 0x02, ///< A length is not encoded in the shortest form.
+    BERTLV_DER_INDEFINITE   = 0x04, ///< An indefinite length is used.
+    BERTLV_DER_UNORDERED    = 0x08, ///< Members of a SET are not sorted.
+};
+
+int    bertlv_der_check(const void *group, size_t size, unsigned options, unsigned *violations);
+size_t bertlv_der_canonicalize(void *buf, size_t bufsize, const void *group, size_t size, unsigned options);
+
+/**
+ * @}
+ */
+
+/**
+ * Special value of the maximum length of ::bertlv_builder_begin
+ * to encode a constructed element with indefinite length.
+ */
+#define BERTLV_LEN_INDEFINITE SIZE_MAX
+
+/**
+ * @class bertlv_builder_t
+ * @brief Encoder of nested TLV data that builds elements in place.
+ * @details Children of a constructed element are encoded directly into its payload,
+ *          and the length field will be patched when the element be ended.
+ *          The builder stops working after any failure,
+ *          and ::bertlv_builder_finish will report that.
+ */
+typedef struct bertlv_builder_t
+{
+    uint8_t *buf;
+    size_t   bufsize;
+    size_t   size;
+    size_t   len_pos [BERTLV_TREE_DEPTH_MAX];
+    size_t   len_size[BERTLV_TREE_DEPTH_MAX];
+    unsigned depth;
+    bool     failed;
+} bertlv_builder_t;
+
+void   bertlv_builder_init(bertlv_builder_t *builder, void *buf, size_t bufsize);
+bool   bertlv_builder_begin(bertlv_builder_t *builder, bertlv_tag_t tag, size_t maxlen);
+bool   bertlv_builder_end(bertlv_builder_t *builder);
+bool   bertlv_builder_append(bertlv_builder_t *builder, bertlv_tag_t tag, const void *data, size_t size);
+void*  bertlv_builder_alloc(bertlv_builder_t *builder, bertlv_tag_t tag, size_t size);
+size_t bertlv_builder_finish(const bertlv_builder_t *builder);
+
+/**
+ * @class bertlv_rwriter_t
+ * @brief Encoder of nested TLV data that fills the buffer from the end to the start.
+ * @details Elements are written in reverse order: the last child first,
+ *          and a constructed element be closed after all of its children,
+ *          so that all lengths are already known when the headers be prepended.
+ *          The output is the same as ::bertlv_encode would produce,
+ *          and no data will be moved.
+ *          The writer stops working after any failure,
+ *          and ::bertlv_rwriter_finish will report that.
+ */
+typedef struct bertlv_rwriter_t
+{
+    uint8_t *buf;
+    size_t   bufsize;
+    size_t   pos;
+    size_t   ends[BERTLV_TREE_DEPTH_MAX];
+    unsigned depth;
+    bool     failed;
+} bertlv_rwriter_t;
+
+void        bertlv_rwriter_init(bertlv_rwriter_t *writer, void *buf, size_t bufsize);
+bool        bertlv_rwriter_open(bertlv_rwriter_t *writer);
+bool        bertlv_rwriter_close(bertlv_rwriter_t *writer, bertlv_tag_t tag);
+bool        bertlv_rwriter_put(bertlv_rwriter_t *writer, bertlv_tag_t tag, const void *data, size_t size);
+void*       bertlv_rwriter_alloc(bertlv_rwriter_t *writer, bertlv_tag_t tag, size_t size);
+const void* bertlv_rwriter_finish(const bertlv_rwriter_t *writer, size_t *size);
+
+int bertlv_edit_replace(void               *buf,
+                        size_t             *size,
+                        size_t              bufsize,
+                        const bertlv_tag_t *tags,
+                        size_t              depth,
+                        const void         *data,
+                        size_t              datasize);
+int bertlv_edit_insert(void               *buf,
+                       size_t             *size,
+                       size_t              bufsize,
+                       const bertlv_tag_t *tags,
+                       size_t              depth,
+                       bertlv_tag_t        tag,
+                       const void         *data,
+                       size_t              datasize);
+int bertlv_edit_delete(void *buf, size_t *size, const bertlv_tag_t *tags, size_t depth);
+
+/**
+ * @brief Entry of a TLV group index.
+ */
+typedef struct bertlv_index_entry_t
+{
+    bertlv_tag_t tag;   ///< Tag of the element.
+    const void  *tlv;   ///< The TLV element.
+} bertlv_index_entry_t;
+
+/**
+ * @class bertlv_index_t
+ * @brief Tag lookup index of a TLV group.
+ * @details The index is a tag-sorted array of entries stored in caller-provided memory,
+ *          and elements with the same tag keep their order in the group.
+ */
+typedef struct bertlv_index_t
+{
+    bertlv_index_entry_t *entries;
+    size_t                count;
+} bertlv_index_t;
+
+size_t      bertlv_index_build(bertlv_index_t       *index,
+                               bertlv_index_entry_t *entries,
+                               size_t                capacity,
+                               const void           *group,
+                               size_t                size);
+const void* bertlv_index_find(const bertlv_index_t *index, bertlv_tag_t tag);
+size_t      bertlv_index_find_all(const bertlv_index_t        *index,
+                                  bertlv_tag_t                 tag,
+                                  const bertlv_index_entry_t **first);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -0,0 +1,232 @@
+/**
+ * @file
+ * @brief     BER-TLV compile-time helpers for C++.
+ * @details   Header-only C++17 layer over bertlv.h,
+ *            with constexpr tag construction, tag properties, size calculation,
+ *            and encoder of fixed-size TLV literals.
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_HPP_
+#define _BERTLV_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "bertlv.h"
+
+namespace bertlv
+{
+
+/**
+ * @name Tag
+ * @{
+ */
+
+/// Make a tag value, the same as ::bertlv_tag_make.
+constexpr bertlv_tag_t tag_make(int cla, int type, long num)
+{
+    const std::uint8_t first = ( ( cla & 0x03 ) << 6 ) | ( ( type & 0x01 ) << 5 );
+    if( num < 0x1F ) return first | ( num & 0x1F );
+
+    std::size_t size = 1;
+    for(long n = num; n; n >>= 7)
+        ++size;
+
+    bertlv_tag_t tag = first | 0x1F;
+    for(std::size_t i = 1; i < size; ++i)
+    {
+        std::uint8_t byte = ( num >> 7*( size - i - 1 ) ) & 0x7F;
+        if( i + 1 != size ) byte |= 0x80;
+
+        tag = ( tag << 8 ) | byte;
+    }
+
+    return tag;
+}
+
+/// Get the number of bytes of a tag.
+constexpr std::size_t tag_size(bertlv_tag_t tag)
+{
+    std::size_t size = 0;
+    for(; tag; tag >>= 8)
+        ++size;
+
+    return size;
+}
+
+/// Get the first (most significant) byte of a tag.
+constexpr std::uint8_t tag_first_byte(bertlv_tag_t tag)
+{
+    while( tag > 0xFF )
+        tag >>= 8;
+
+    return tag;
+}
+
+/// Check if a tag is valid, the same as ::bertlv_tag_is_valid.
+constexpr bool tag_is_valid(bertlv_tag_t tag)
+{
+    const std::size_t size = tag_size(tag);
+    if( !size ) return false;
+
+    if( ( tag_first_byte(tag) & 0x1F ) != 0x1F ) return size == 1;
+    if( size < 2 || ( tag & 0x80 ) ) return false;
+
+    for(std::size_t i = 1; i < size - 1; ++i)
+    {
+        if( !( ( tag >> 8*i ) & 0x80 ) ) return false;
+    }
+
+    return true;
+}
+
+/// Get the class of a tag, the same as ::bertlv_tag_get_class.
+constexpr int tag_class(bertlv_tag_t tag)
+{
+    return tag_first_byte(tag) >> 6;
+}
+
+/// Get the type of a tag, the same as ::bertlv_tag_get_type.
+constexpr int tag_type(bertlv_tag_t tag)
+{
+    return ( tag_first_byte(tag) >> 5 ) & 0x01;
+}
+
+/// Get the number of a tag, the same as ::bertlv_tag_get_number.
+constexpr long tag_number(bertlv_tag_t tag)
+{
+    const std::uint8_t first = tag_first_byte(tag);
+    if( ( first & 0x1F ) != 0x1F ) return first & 0x1F;
+
+    long num = 0;
+    for(std::size_t i = tag_size(tag) - 1; i--; )
+        num = ( num << 7 ) | ( ( tag >> 8*i ) & 0x7F );
+
+    return num;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @name Size Calculation
+ * @{
+ */
+
+/// Get the encoded size of a length field.
+constexpr std::size_t len_size(std::size_t length)
+{
+    if( length <= 0x7F ) return 1;
+
+    std::size_t count = 0;
+    for(; length; length >>= 8)
+        ++count;
+
+    return count + 1;
+}
+
+/// Get the encoded size of a TLV element.
+constexpr std::size_t encoded_size(bertlv_tag_t tag, std::size_t length)
+{
+    return tag_size(tag) + len_size(length) + length;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @name Literal Encoding
+ * @{
+ */
+
+/**
+ * Encode a TLV element with fixed-size payload at compile time.
+ *
+ * @tparam Tag   Tag of the element.
+ * @tparam N     Payload size.
+ * @param  value The payload data.
+ * @return The encoded element, the same as ::bertlv_encode would produce.
+ *
+ * Example:
+ * @code
+ * constexpr auto atc = bertlv::encode<0x9F36>(std::array<std::uint8_t, 2>{ 0x00, 0x01 });
+ * @endcode
+ */
+template<bertlv_tag_t Tag, std::size_t N>
+constexpr std::array<std::uint8_t, encoded_size(Tag, N)> encode(const std::array<std::uint8_t, N> &value)
+{
+    static_assert(tag_is_valid(Tag), "Invalid tag");
+
+    std::array<std::uint8_t, encoded_size(Tag, N)> tlv{};
+    std::size_t pos = 0;
+
+    for(std::size_t i = tag_size(Tag); i--; )
+        tlv[pos++] = ( Tag >> 8*i ) & 0xFF;
+
+    const std::size_t lensize = len_size(N);
+    if( lensize == 1 )
+    {
+        tlv[pos++] = N;
+    }
+    else
+    {
+        tlv[pos++] = 0x80 | ( lensize - 1 );
+        for(std::size_t i = lensize - 1; i--; )
+            tlv[pos++] = ( N >> 8*i ) & 0xFF;
+    }
+
+    for(std::size_t i = 0; i < N; ++i)
+        tlv[pos++] = value[i];
+
+    return tlv;
+}
+
+/**
+ * Encode a primitive TLV element with the payload bytes given as template arguments.
+ *
+ * Example:
+ * @code
+ * constexpr auto atc = bertlv::tlv<0x9F36, 0x00, 0x01>();
+ * @endcode
+ */
+template<bertlv_tag_t Tag, std::uint8_t... Bytes>
+constexpr auto tlv()
+{
+    return encode<Tag>(std::array<std::uint8_t, sizeof...(Bytes)>{ Bytes... });
+}
+
+/**
+ * Encode a constructed TLV element from encoded children at compile time.
+ *
+ * Example:
+ * @code
+ * constexpr auto fci = bertlv::constructed<0x6F>(bertlv::tlv<0x84, 0xA0, 0x00>(),
+ *                                                bertlv::constructed<0xA5>());
+ * @endcode
+ */
+template<bertlv_tag_t Tag, std::size_t... Ns>
+constexpr auto constructed(const std::array<std::uint8_t, Ns>&... children)
+{
+    static_assert(tag_type(Tag) == BERTLV_TYPE_CONSTRUCTED, "Tag is not constructed");
+
+    std::array<std::uint8_t, ( Ns + ... + 0 )> value{};
+    [[maybe_unused]] std::size_t pos = 0;
+
+    ( [&](const auto &child)
+      {
+          for(std::size_t i = 0; i < child.size(); ++i)
+              value[pos++] = child[i];
+      }(children), ... );
+
+    return encode<Tag>(value);
+}
+
+/**
+ * @}
+ */
+
+}  // namespace bertlv
+
+#endif
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bertlv.h"
+
+/*
+ * Micro-benchmarks of the hot paths.
+ *
+ * Usage: bertlv_bench [samples]
+ *
+ * Each line of the output is a JSON object of one benchmark:
+ * the throughput in MB/s of the corpus and in operations per second
+ * (the unit of an operation is given, e.g. one element be parsed or one lookup),
+ * and the percentiles over all samples of the average time (ns) of one operation in a sample
+ * (sample_p50_ns etc., they are not latencies of single operations).
+ */
+
+#define SAMPLES_DEFAULT 200
+#define SAMPLES_MAX     10000
+
+static volatile size_t sink;
+
+typedef struct corpus_t
+{
+    const char *name;
+    uint8_t    *data;
+    size_t      size;
+    size_t      elements;
+    uint8_t    *output;     // A buffer of the corpus size to encode into, or NULL.
+} corpus_t;
+
+typedef struct bench_t
+{
+    const char *name;
+    const char *unit;
+    size_t    (*run)(const corpus_t *corpus);   // Returns the number of operations.
+} bench_t;
+
+//------------------------------------------------------------------------------
+//---- Corpora -----------------------------------------------------------------
+//------------------------------------------------------------------------------
+static const struct
+{
+    bertlv_tag_t tag;
+    size_t       size;
+} emv_record[] =
+{
+    { 0x9F02, 6 }, { 0x9F03, 6 }, { 0x9F1A, 2 }, { 0x95,   5 }, { 0x5F2A, 2 },
+    { 0x9A,   3 }, { 0x9C,   1 }, { 0x9F37, 4 }, { 0x82,   2 }, { 0x9F36, 2 },
+    { 0x9F10, 32 }, { 0x9F26, 8 }, { 0x9F27, 1 }, { 0x9F34, 3 }, { 0x84,  7 },
+    { 0x9F09, 2 }, { 0x9F1E, 8 }, { 0x9F33, 3 }, { 0x9F35, 1 }, { 0x9F41, 4 },
+    { 0x5A,   8 }, { 0x5F34, 1 }, { 0x57,   19 }, { 0x5F24, 3 }, { 0x9F06, 7 },
+    { 0x50,   16 }, { 0x9F12, 16 }, { 0x87,  1 }, { 0x9F07, 2 }, { 0x8E,  12 },
+    { 0x9F0D, 5 }, { 0x9F0E, 5 }, { 0x9F0F, 5 }, { 0x5F28, 2 }, { 0x9F4E, 20 },
+    { 0xDF8101, 4 }, { 0xDF8102, 2 }, { 0x9F6E, 4 }, { 0x9F7C, 32 }, { 0x5F20, 26 },
+};
+
+static const size_t emv_record_count = sizeof(emv_record)/sizeof(emv_record[0]);
+
+static size_t make_emv_record(uint8_t *buf, size_t bufsize, unsigned seed)
+{
+    size_t size = 0;
+    for(size_t i=0; i<emv_record_count; ++i)
+    {
+        uint8_t value[64];
+        for(size_t j=0; j<emv_record[i].size; ++j)
+            value[j] = seed * 31 + i * 7 + j;
+
+        size += bertlv_encode(buf + size, bufsize - size, emv_record[i].tag, value, emv_record[i].size);
+    }
+
+    return size;
+}
+
+static void make_emv_flat(corpus_t *corpus, size_t target)
+{
+    // Many EMV records concatenated in one flat group.
+    uint8_t record[1024];
+    size_t  record_size = make_emv_record(record, sizeof(record), 0);
+    size_t  count       = target / record_size;
+
+    corpus->name     = "emv_flat";
+    corpus->size     = count * record_size;
+    corpus->data     = malloc(corpus->size);
+    corpus->elements = count * emv_record_count;
+    corpus->output   = NULL;
+
+    for(size_t i=0; i<count; ++i)
+        make_emv_record(corpus->data + i * record_size, record_size, i);
+}
+
+static size_t make_nested_message(uint8_t *buf, size_t bufsize, unsigned depth, size_t *elements)
+{
+    // A constructed element of the depth, and each level holds some EMV elements.
+    bertlv_builder_t builder;
+    bertlv_builder_init(&builder, buf, bufsize);
+
+    static const bertlv_tag_t levels[] = { 0x70, 0x77, 0xA5, 0xBF0C, 0x61, 0x73, 0xE1, 0xE2 };
+    for(unsigned i=0; i<depth; ++i)
+    {
+        bertlv_builder_begin(&builder, levels[i % (sizeof(levels)/sizeof(levels[0]))], 0x100);
+        ++*elements;
+
+        for(size_t j=0; j<6; ++j)
+        {
+            uint8_t value[32] = { (uint8_t)i, (uint8_t)j };
+            bertlv_builder_append(&builder, emv_record[i+j].tag, value, emv_record[i+j].size);
+            ++*elements;
+        }
+    }
+
+    for(unsigned i=0; i<depth; ++i)
+        bertlv_builder_end(&builder);
+
+    return bertlv_builder_finish(&builder);
+}
+
+static void make_nested(corpus_t *corpus, size_t target)
+{
+    // Deeply nested messages concatenated in one group.
+    uint8_t message[4096];
+    size_t  elements     = 0;
+    size_t  message_size = make_nested_message(message, sizeof(message), 8, &elements);
+    size_t  count        = target / message_size;
+
+    corpus->name     = "nested";
+    corpus->size     = count * message_size;
+    corpus->data     = malloc(corpus->size);
+    corpus->elements = count * elements;
+    corpus->output   = NULL;
+
+    for(size_t i=0; i<count; ++i)
+        memcpy(corpus->data + i * message_size, message, message_size);
+}
+
+static void make_large_value(corpus_t *corpus, size_t target)
+{
+    // One primitive element with a large payload.
+    uint8_t *value = malloc(target);
+    for(size_t i=0; i<target; ++i)
+        value[i] = i;
+
+    corpus->name     = "large_value";
+    corpus->size     = bertlv_encode(NULL, 0, 0xDF01, NULL, target);
+    corpus->data     = malloc(corpus->size);
+    corpus->elements = 1;
+    corpus->output   = malloc(corpus->size);
+
+    bertlv_encode(corpus->data, corpus->size, 0xDF01, value, target);
+    free(value);
+}
+
+//------------------------------------------------------------------------------
+//---- Benchmarks --------------------------------------------------------------
+//------------------------------------------------------------------------------
+static size_t run_iter_get_next(const corpus_t *corpus)
+{
+    bertlv_iter_t iter;
+    bertlv_iter_init(&iter, corpus->data, corpus->size);
+
+    size_t count = 0;
+    for(const void *tlv; ( tlv = bertlv_iter_get_next(&iter) ); ++count)
+        sink += (size_t)tlv;
+
+    return count;
+}
+
+static size_t run_tree_iter(const corpus_t *corpus)
+{
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, corpus->data, corpus->size);
+
+    size_t          count = 0;
+    bertlv_header_t header;
+    while( bertlv_tree_iter_get_next(&iter, &header) )
+    {
+        sink += header.length;
+        ++count;
+    }
+
+    return count;
+}
+
+static size_t run_grp_count(const corpus_t *corpus)
+{
+    size_t count = bertlv_grp_count(corpus->data, corpus->size);
+    sink += count;
+    return count;
+}
+
+static size_t run_grp_find(const corpus_t *corpus)
+{
+    // Look up tags of a record (near the end, and absent) record by record.
+    uint8_t record[1024];
+    size_t  record_size = make_emv_record(record, sizeof(record), 0);
+
+    size_t count = 0;
+    for(size_t pos = 0; pos + record_size <= corpus->size; pos += record_size)
+    {
+        sink += (size_t)bertlv_grp_find(corpus->data + pos, record_size, 0x9F7C);
+        sink += (size_t)bertlv_grp_find(corpus->data + pos, record_size, 0x9F36);
+        sink += (size_t)bertlv_grp_find(corpus->data + pos, record_size, 0xDF7F);
+        count += 3;
+    }
+
+    return count;
+}
+
+static size_t run_grp_find_many(const corpus_t *corpus)
+{
+    // The same lookups as above, in one pass of each record.
+    static const bertlv_tag_t tags[] = { 0x9F7C, 0x9F36, 0xDF7F };
+
+    uint8_t record[1024];
+    size_t  record_size = make_emv_record(record, sizeof(record), 0);
+
+    size_t count = 0;
+    for(size_t pos = 0; pos + record_size <= corpus->size; pos += record_size)
+    {
+        const void *found[3];
+        sink += bertlv_grp_find_many(corpus->data + pos, record_size, tags, 3, found);
+        sink += (size_t)found[0];
+        count += 3;
+    }
+
+    return count;
+}
+
+static size_t run_encode(const corpus_t *corpus)
+{
+    // Re-encode every element of the corpus.
+    static uint8_t buf[4096];
+
+    bertlv_iter_t iter;
+    bertlv_iter_init(&iter, corpus->data, corpus->size);
+
+    size_t          count = 0;
+    bertlv_header_t header;
+    while( bertlv_iter_get_next_header(&iter, &header) )
+    {
+        sink += bertlv_encode(buf, sizeof(buf), header.tag, header.value, header.length);
+        ++count;
+    }
+
+    return count;
+}
+
+static size_t run_encode_large(const corpus_t *corpus)
+{
+    bertlv_header_t header;
+    bertlv_decode_header_s(corpus->data, corpus->size, &header);
+    sink += bertlv_encode(corpus->output, corpus->size, header.tag, header.value, header.length);
+
+    return 1;
+}
+
+static size_t run_tag_props(const corpus_t *corpus)
+{
+    bertlv_iter_t iter;
+    bertlv_iter_init(&iter, corpus->data, corpus->size);
+
+    size_t count = 0;
+    for(const void *tlv; ( tlv = bertlv_iter_get_next(&iter) ); ++count)
+    {
+        bertlv_tag_t tag = bertlv_get_tag(tlv);
+        sink += bertlv_tag_is_valid(tag);
+        sink += bertlv_tag_get_class(tag);
+        sink += bertlv_tag_get_type(tag);
+        sink += bertlv_tag_get_number(tag);
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+//---- Measurement -------------------------------------------------------------
+//------------------------------------------------------------------------------
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return ( x > y ) - ( x < y );
+}
+
+static double percentile(const double *sorted, size_t count, double p)
+{
+    size_t index = p * ( count - 1 ) + 0.5;
+    return sorted[index];
+}
+
+static void measure(const bench_t *bench, const corpus_t *corpus, size_t samples)
+{
+    static double averages[SAMPLES_MAX];
+
+    bench->run(corpus);    // Warm up.
+
+    double total_ns  = 0;
+    size_t total_ops = 0;
+    for(size_t i=0; i<samples; ++i)
+    {
+        double start = now_ns();
+        size_t ops   = bench->run(corpus);
+        double spent = now_ns() - start;
+
+        averages[i]  = spent / ( ops ? ops : 1 );
+        total_ns    += spent;
+        total_ops   += ops;
+    }
+
+    qsort(averages, samples, sizeof(averages[0]), compare_double);
+
+    double seconds = total_ns / 1e9;
+    printf("{\"bench\":\"%s\",\"corpus\":\"%s\",\"bytes\":%zu,\"elements\":%zu,\"samples\":%zu,"
+           "\"unit\":\"%s\",\"ops\":%zu,\"mb_per_s\":%.2f,\"ops_per_s\":%.0f,"
+           "\"sample_p50_ns\":%.2f,\"sample_p90_ns\":%.2f,\"sample_p99_ns\":%.2f,\"sample_max_ns\":%.2f}\n",
+           bench->name,
+           corpus->name,
+           corpus->size,
+           corpus->elements,
+           samples,
+           bench->unit,
+           total_ops / samples,
+           corpus->size * samples / seconds / 1e6,
+           total_ops / seconds,
+           percentile(averages, samples, 0.50),
+           percentile(averages, samples, 0.90),
+           percentile(averages, samples, 0.99),
+           averages[samples-1]);
+    fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    size_t samples = ( argc > 1 )?( strtoul(argv[1], NULL, 10) ):( SAMPLES_DEFAULT );
+    if( samples < 1 || samples > SAMPLES_MAX )
+    {
+        fprintf(stderr, "Usage: %s [samples (1 ~ %d)]\n", argv[0], SAMPLES_MAX);
+        return 1;
+    }
+
+    corpus_t emv_flat, nested, large_value;
+    make_emv_flat(&emv_flat, 1 << 20);
+    make_nested(&nested, 1 << 20);
+    make_large_value(&large_value, 1 << 24);
+
+    static const bench_t iter_get_next = { "iter_get_next", "element", run_iter_get_next };
+    static const bench_t tree_iter     = { "tree_iter",     "element", run_tree_iter     };
+    static const bench_t grp_count     = { "grp_count",     "element", run_grp_count     };
+    static const bench_t grp_find      = { "grp_find",      "lookup",  run_grp_find      };
+    static const bench_t grp_find_many = { "grp_find_many", "lookup",  run_grp_find_many };
+    static const bench_t encode        = { "encode",        "element", run_encode        };
+    static const bench_t encode_large  = { "encode_large",  "element", run_encode_large  };
+    static const bench_t tag_props     = { "tag_props",     "tag",     run_tag_props     };
+
+    measure(&iter_get_next, &emv_flat,    samples);
+    measure(&tree_iter,     &nested,      samples);
+    measure(&grp_count,     &emv_flat,    samples);
+    measure(&grp_find,      &emv_flat,    samples);
+    measure(&grp_find_many, &emv_flat,    samples);
+    measure(&encode,        &emv_flat,    samples);
+    measure(&encode_large,  &large_value, samples);
+    measure(&tag_props,     &emv_flat,    samples);
+
+    free(emv_flat.data);
+    free(nested.data);
+    free(large_value.data);
+    free(large_value.output);
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "bertlv_dom.h"
+
+//------------------------------------------------------------------------------
+//---- Arena -------------------------------------------------------------------
+//------------------------------------------------------------------------------
+typedef union arena_align_t
+{
+    uint64_t  u;
+    double    d;
+    void     *p;
+} arena_align_t;
+
+static
+size_t arena_align(const bertlv_arena_t *arena)
+{
+    static const size_t align = _Alignof(arena_align_t);
+
+    uintptr_t addr = (uintptr_t)( arena->buf + arena->used );
+    return ( align - addr % align ) % align;
+}
+//------------------------------------------------------------------------------
+void bertlv_arena_init(bertlv_arena_t *arena, void *buf, size_t size)
+{
+    /**
+     * @memberof bertlv_arena_t
+     * @brief Constructor.
+     *
+     * @param arena The arena it self.
+     * @param buf   The memory to be allocated from.
+     * @param size  Size of the memory.
+     */
+    arena->buf  = buf;
+    arena->size = buf ? size : 0;
+    arena->used = 0;
+}
+//------------------------------------------------------------------------------
+void* bertlv_arena_alloc(bertlv_arena_t *arena, size_t size)
+{
+    /**
+     * @memberof bertlv_arena_t
+     * @brief Allocate a memory block.
+     *
+     * @param arena The arena object.
+     * @param size  Size of the memory block.
+     * @return The memory block (aligned for integers, pointers and `double`) if succeed; or
+     *         NULL if there have no enough space.
+     */
+    size_t pad = arena_align(arena);
+    if( arena->size - arena->used < pad ||
+        arena->size - arena->used - pad < size )
+        return NULL;
+
+    void *block = arena->buf + arena->used + pad;
+    arena->used += pad + size;
+
+    return block;
+}
+//------------------------------------------------------------------------------
+//---- DOM ---------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int bertlv_dom_parse(bertlv_dom_t *dom, bertlv_arena_t *arena, const void *group, size_t size)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Parse a TLV group and all of its nested elements.
+     *
+     * @param dom   The object to receive the result.
+     * @param arena The arena to allocate nodes from.
+     * @param group A set of data of TLV elements.
+     * @param size  Size of the input data.
+     * @return ::BERTLV_OK if succeed; or one of ::bertlv_error_t if failed.
+     *
+     * @remarks The node array grows in the free space at the end of the arena,
+     *          so no more allocation should be made from the same arena
+     *          during the parsing. The arena keeps unchanged if failed.
+     */
+    dom->nodes = NULL;
+    dom->count = 0;
+
+    size_t pad   = arena_align(arena);
+    size_t avail = arena->size - arena->used;
+    if( avail < pad ) return BERTLV_ERR_NO_SPACE;
+
+    bertlv_node_t *nodes    = (bertlv_node_t*)( arena->buf + arena->used + pad );
+    size_t         capacity = ( avail - pad ) / sizeof(bertlv_node_t);
+    if( capacity > BERTLV_NODE_NONE ) capacity = BERTLV_NODE_NONE;
+
+    uint32_t last[BERTLV_TREE_DEPTH_MAX+1];
+    last[0] = BERTLV_NODE_NONE;
+
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, group, size);
+
+    size_t          count = 0;
+    bertlv_header_t header;
+    for(const void *tlv; ( tlv = bertlv_tree_iter_get_next(&iter, &header) ); ++count)
+    {
+        if( count >= capacity ) return BERTLV_ERR_NO_SPACE;
+
+        unsigned       depth = bertlv_tree_iter_get_depth(&iter);
+        bertlv_node_t *node  = &nodes[count];
+
+        node->tag    = header.tag;
+        node->length = header.length;
+        node->tlv    = tlv;
+        node->value  = header.value;
+        node->parent = depth ? last[depth-1] : BERTLV_NODE_NONE;
+        node->child  = BERTLV_NODE_NONE;
+        node->next   = BERTLV_NODE_NONE;
+        node->depth  = depth;
+
+        if( last[depth] != BERTLV_NODE_NONE )
+            nodes[last[depth]].next = count;
+        else if( node->parent != BERTLV_NODE_NONE )
+            nodes[node->parent].child = count;
+
+        last[depth]   = count;
+        last[depth+1] = BERTLV_NODE_NONE;
+    }
+
+    int err = bertlv_tree_iter_get_error(&iter);
+    if( err ) return err;
+
+    if( count )
+    {
+        dom->nodes   = nodes;
+        dom->count   = count;
+        arena->used += pad + count * sizeof(bertlv_node_t);
+    }
+
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+const bertlv_node_t* bertlv_dom_find_child(const bertlv_dom_t *dom, const bertlv_node_t *parent, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Find a child node by tag.
+     *
+     * @param dom    The DOM object.
+     * @param parent The parent node, or NULL to search the top level elements.
+     * @param tag    The tag to search.
+     * @return The first child which has the tag if found; or NULL if not.
+     */
+    const bertlv_node_t *node = parent ?
+                                bertlv_dom_get_child(dom, parent) :
+                                bertlv_dom_get_node(dom, 0);
+    for(; node; node = bertlv_dom_get_next(dom, node))
+    {
+        if( node->tag == tag ) return node;
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+const bertlv_node_t* bertlv_dom_find_path(const bertlv_dom_t *dom, const bertlv_tag_t *tags, size_t depth)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Find a node by a path of tags from the top level.
+     *
+     * @param dom   The DOM object.
+     * @param tags  Tags of each level, from the outermost one.
+     * @param depth Number of tags in the path.
+     * @return The node if found; or NULL if not.
+     */
+    const bertlv_node_t *node = NULL;
+    for(size_t i=0; i<depth; ++i)
+    {
+        node = bertlv_dom_find_child(dom, node, tags[i]);
+        if( !node ) return NULL;
+    }
+
+    return node;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+/**
+ * @file
+ * @brief     BER-TLV document object model.
+ * @details   Parse a nested message into a flat array of nodes for random access.
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_DOM_H_
+#define _BERTLV_DOM_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class bertlv_arena_t
+ * @brief Bump allocator on a caller-supplied buffer.
+ * @details Memory be allocated by moving a cursor only,
+ *          and all of them be released at once by ::bertlv_arena_reset,
+ *          typically once per message.
+ */
+typedef struct bertlv_arena_t
+{
+    uint8_t *buf;
+    size_t   size;
+    size_t   used;
+} bertlv_arena_t;
+
+void  bertlv_arena_init(bertlv_arena_t *arena, void *buf, size_t size);
+void* bertlv_arena_alloc(bertlv_arena_t *arena, size_t size);
+
+static inline
+void bertlv_arena_reset(bertlv_arena_t *arena)
+{
+    /**
+     * @memberof bertlv_arena_t
+     * @brief Release all memory allocated.
+     */
+    arena->used = 0;
+}
+
+static inline
+size_t bertlv_arena_get_used(const bertlv_arena_t *arena)
+{
+    /**
+     * @memberof bertlv_arena_t
+     * @brief Get the number of bytes be allocated (including alignment padding).
+     */
+    return arena->used;
+}
+
+/**
+ * Index value that refers to no node.
+ */
+#define BERTLV_NODE_NONE UINT32_MAX
+
+/**
+ * A node of TLV element.
+ * @details The node refers to the original input data, and nothing be copied.
+ */
+typedef struct bertlv_node_t
+{
+    bertlv_tag_t tag;       ///< Tag of the element.
+    size_t       length;    ///< Payload size of the element.
+    const void  *tlv;       ///< Start of the element in the input data.
+    const void  *value;     ///< Payload data of the element.
+    uint32_t     parent;    ///< Index of the parent node, or ::BERTLV_NODE_NONE for top level elements.
+    uint32_t     child;     ///< Index of the first child, or ::BERTLV_NODE_NONE if none.
+    uint32_t     next;      ///< Index of the next sibling, or ::BERTLV_NODE_NONE if none.
+    uint32_t     depth;     ///< Nesting depth of the element, ZERO for top level elements.
+} bertlv_node_t;
+
+/**
+ * @class bertlv_dom_t
+ * @brief Parsed tree of a TLV group.
+ * @details All nodes be stored in one contiguous array in pre-order,
+ *          so the first node (if any) is the first top level element,
+ *          and the descendants of a node always follow it.
+ */
+typedef struct bertlv_dom_t
+{
+    bertlv_node_t *nodes;
+    size_t         count;
+} bertlv_dom_t;
+
+int         bertlv_dom_parse(bertlv_dom_t *dom, bertlv_arena_t *arena, const void *group, size_t size);
+const bertlv_node_t* bertlv_dom_find_child(const bertlv_dom_t *dom, const bertlv_node_t *parent, bertlv_tag_t tag);
+const bertlv_node_t* bertlv_dom_find_path(const bertlv_dom_t *dom, const bertlv_tag_t *tags, size_t depth);
+
+static inline
+const bertlv_node_t* bertlv_dom_get_node(const bertlv_dom_t *dom, uint32_t index)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Get a node by its index.
+     *
+     * @return The node if the index is valid; or NULL if not.
+     */
+    return index < dom->count ? &dom->nodes[index] : NULL;
+}
+
+static inline
+const bertlv_node_t* bertlv_dom_get_child(const bertlv_dom_t *dom, const bertlv_node_t *node)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Get the first child of a node.
+     */
+    return bertlv_dom_get_node(dom, node->child);
+}
+
+static inline
+const bertlv_node_t* bertlv_dom_get_next(const bertlv_dom_t *dom, const bertlv_node_t *node)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Get the next sibling of a node.
+     */
+    return bertlv_dom_get_node(dom, node->next);
+}
+
+static inline
+const bertlv_node_t* bertlv_dom_get_parent(const bertlv_dom_t *dom, const bertlv_node_t *node)
+{
+    /**
+     * @memberof bertlv_dom_t
+     * @brief Get the parent of a node.
+     */
+    return bertlv_dom_get_node(dom, node->parent);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bertlv_file.h"
+
+//------------------------------------------------------------------------------
+bool bertlv_file_open(bertlv_file_t *file, const char *filename)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Map a TLV file into memory.
+     *
+     * @param file     The file object.
+     * @param filename Name of the file to be opened.
+     * @return TRUE if succeed; and FALSE if not.
+     *
+     * @remarks The object must be closed by ::bertlv_file_close if succeed.
+     */
+    file->data = NULL;
+    file->size = 0;
+    bertlv_file_rewind(file);
+
+    int fd = open(filename, O_RDONLY);
+    if( fd < 0 ) return false;
+
+    bool succ = false;
+    do
+    {
+        struct stat info;
+        if( fstat(fd, &info) ) break;
+        if( (uint64_t)info.st_size > SIZE_MAX ) break;
+
+        if( info.st_size )
+        {
+            void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if( data == MAP_FAILED ) break;
+
+            posix_madvise(data, info.st_size, POSIX_MADV_SEQUENTIAL);
+
+            file->data = data;
+            file->size = info.st_size;
+        }
+
+        succ = true;
+    } while(false);
+
+    close(fd);
+    return succ;
+}
+//------------------------------------------------------------------------------
+void bertlv_file_close(bertlv_file_t *file)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Unmap the file.
+     *
+     * @param file The file object.
+     */
+    if( file->data )
+        munmap((void*)file->data, file->size);
+
+    file->data = NULL;
+    file->size = 0;
+    bertlv_file_rewind(file);
+}
+//------------------------------------------------------------------------------
+static
+bool bertlv_file_decode_definite(const bertlv_file_t *file, size_t pos, bertlv_header_t *header)
+{
+    // Indefinite lengths are not accepted while resyncing,
+    // because searching the end-of-contents of every candidate may scan to the end of file.
+    bertlv_header64_t header64;
+    if( bertlv_decode_header64(file->data + pos, file->size - pos, &header64) ) return false;
+    if( header64.indefinite ) return false;
+
+    return !bertlv_decode_header_s(file->data + pos, file->size - pos, header);
+}
+//------------------------------------------------------------------------------
+static
+bool bertlv_file_is_record(const bertlv_file_t *file, size_t pos, bertlv_header_t *header)
+{
+    if( !bertlv_file_decode_definite(file, pos, header) ) return false;
+
+    // A candidate found by resync must be followed by another record
+    // or the end of file, to reduce false matches inside corrupt data.
+    size_t next = pos + header->total_size;
+    if( next == file->size ) return true;
+
+    bertlv_header_t next_header;
+    return bertlv_file_decode_definite(file, next, &next_header);
+}
+//------------------------------------------------------------------------------
+const void* bertlv_file_get_next(bertlv_file_t *file, bertlv_header_t *header)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Get the next record, and skip corrupt data if needed.
+     *
+     * @param file   The file object.
+     * @param header Receives the header information of the record returned.
+     * @return The next record if found; or
+     *         NULL if no more records.
+     *
+     * @remarks When a record cannot be parsed,
+     *          the scanner moves forward byte by byte until a position where
+     *          a record can be parsed and be followed by another parseable record
+     *          (or the end of file).
+     *          Records with indefinite length are not accepted as resync points,
+     *          so that the cost of each candidate is bounded.
+     */
+    if( file->pos >= file->size ) return NULL;
+
+    if( !bertlv_decode_header_s(file->data + file->pos, file->size - file->pos, header) )
+    {
+        const void *tlv = file->data + file->pos;
+        file->pos += header->total_size;
+        return tlv;
+    }
+
+    ++file->resyncs;
+    for(size_t pos = file->pos + 1; pos < file->size; ++pos)
+    {
+        if( !bertlv_file_is_record(file, pos, header) ) continue;
+
+        file->skipped += pos - file->pos;
+        file->pos      = pos + header->total_size;
+        return file->data + pos;
+    }
+
+    file->skipped += file->size - file->pos;
+    file->pos      = file->size;
+    return NULL;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief     BER-TLV file scanner.
+ * @details   Memory-mapped reader of files of concatenated TLV records (POSIX only).
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_FILE_H_
+#define _BERTLV_FILE_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class bertlv_file_t
+ * @brief Memory-mapped TLV file scanner.
+ * @details The file will be mapped read-only with sequential access hint,
+ *          and the records can be iterated by ::bertlv_file_get_next,
+ *          which recovers from corrupt records,
+ *          or by ::bertlv_iter_t on the mapped data directly.
+ */
+typedef struct bertlv_file_t
+{
+    const uint8_t *data;
+    size_t         size;
+    size_t         pos;
+    size_t         skipped;
+    unsigned       resyncs;
+} bertlv_file_t;
+
+bool        bertlv_file_open(bertlv_file_t *file, const char *filename);
+void        bertlv_file_close(bertlv_file_t *file);
+const void* bertlv_file_get_next(bertlv_file_t *file, bertlv_header_t *header);
+
+static inline
+void bertlv_file_init_iter(const bertlv_file_t *file, bertlv_iter_t *iter)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Initialise a group iterator over the whole file.
+     *
+     * @param file The file object.
+     * @param iter The iterator to be initialised.
+     *
+     * @remarks The iterator stops at the first corrupt record,
+     *          use ::bertlv_file_get_next instead to skip them.
+     */
+    bertlv_iter_init(iter, file->data, file->size);
+}
+
+static inline
+void bertlv_file_rewind(bertlv_file_t *file)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Move back to the first record and clear the resync statistics.
+     */
+    file->pos      = 0;
+    file->skipped  = 0;
+    file->resyncs  = 0;
+}
+
+static inline
+size_t bertlv_file_get_skipped(const bertlv_file_t *file)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Get the number of bytes be skipped to recover from corrupt records.
+     */
+    return file->skipped;
+}
+
+static inline
+unsigned bertlv_file_get_resyncs(const bertlv_file_t *file)
+{
+    /**
+     * @memberof bertlv_file_t
+     * @brief Get the number of times that the scanner recovered from corrupt records.
+     */
+    return file->resyncs;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
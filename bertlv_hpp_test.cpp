@@ -0,0 +1,63 @@
+#include <cassert>
+#include <cstring>
+#include "bertlv.hpp"
+
+// Compile-time results.
+static_assert( bertlv::tag_make(2, 1, 6)   == 0xA6 );
+static_assert( bertlv::tag_make(1, 0, 30)  == 0x5E );
+static_assert( bertlv::tag_make(1, 0, 31)  == 0x5F1F );
+static_assert( bertlv::tag_make(2, 1, 793) == 0xBF8619 );
+static_assert( bertlv::tag_make(3, 1, 2)   == BERTLV_TAG_MAKE(3, 1, 2) );
+
+static_assert( bertlv::tag_size(0x9F02) == 2 );
+static_assert( bertlv::tag_size(0xDF8101) == 3 );
+static_assert( bertlv::tag_first_byte(0x9F8101) == 0x9F );
+static_assert( bertlv::tag_is_valid(0x9F8101) );
+static_assert( !bertlv::tag_is_valid(0) );
+static_assert( !bertlv::tag_is_valid(0x1F) );
+static_assert( !bertlv::tag_is_valid(0xA6A6) );
+static_assert( bertlv::tag_class(0xBF8619) == BERTLV_CLASS_CONTEXT );
+static_assert( bertlv::tag_type(0xBF8619) == BERTLV_TYPE_CONSTRUCTED );
+static_assert( bertlv::tag_number(0xBF8619) == 793 );
+
+static_assert( bertlv::len_size(0x7F) == 1 );
+static_assert( bertlv::len_size(500) == BERTLV_LEN_SIZE(500) );
+static_assert( bertlv::encoded_size(0xDF07, 500) == BERTLV_TOTAL_SIZE(0xDF07, 500) );
+
+static constexpr auto atc = bertlv::tlv<0x9F36, 0x00, 0x01>();
+static_assert( atc.size() == 5 );
+static_assert( atc[0] == 0x9F && atc[1] == 0x36 && atc[2] == 0x02 && atc[4] == 0x01 );
+
+static constexpr auto fci = bertlv::constructed<0x6F>(bertlv::tlv<0x84, 0xA0, 0x00>(),
+                                                      bertlv::constructed<0xA5>());
+static_assert( fci.size() == 8 );
+static_assert( fci[0] == 0x6F && fci[1] == 0x06 && fci[6] == 0xA5 && fci[7] == 0x00 );
+
+//------------------------------------------------------------------------------
+extern "C" void test_tlv_hpp(void)
+{
+    // The same results as the C functions.
+    static const bertlv_tag_t tags[] =
+    {
+        0xA6, 0xBF8619, 0x5E, 0x5F1F, 0x5F817F, 0x9F02, 0xDF8101,
+        0, 0x1F, 0x5F80, 0x5F01FF, 0xA6A6, 0x9F8181,
+    };
+
+    for(bertlv_tag_t tag : tags)
+    {
+        assert( bertlv::tag_is_valid(tag) == bertlv_tag_is_valid(tag) );
+        if( !bertlv_tag_is_valid(tag) ) continue;
+
+        assert( bertlv::tag_class (tag) == bertlv_tag_get_class (tag) );
+        assert( bertlv::tag_type  (tag) == bertlv_tag_get_type  (tag) );
+        assert( bertlv::tag_number(tag) == bertlv_tag_get_number(tag) );
+    }
+
+    static const std::uint8_t payload[300] = {};
+    const auto large = bertlv::encode<0xDF07>(std::array<std::uint8_t, 300>{});
+
+    std::uint8_t buf[512];
+    assert( large.size() == bertlv_encode(buf, sizeof(buf), 0xDF07, payload, sizeof(payload)) );
+    assert( 0 == std::memcmp(buf, large.data(), large.size()) );
+}
+//------------------------------------------------------------------------------
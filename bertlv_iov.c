@@ -0,0 +1,232 @@
+#include "bertlv_iov.h"
+
+//------------------------------------------------------------------------------
+void bertlv_iov_init(bertlv_iov_t *enc, void *hdrbuf, size_t hdrsize, struct iovec *iov, size_t iovmax)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Constructor.
+     *
+     * @param enc     The encoder it self.
+     * @param hdrbuf  The buffer to store tag and length fields.
+     * @param hdrsize Size of the header buffer.
+     * @param iov     The I/O vector to be filled.
+     * @param iovmax  Number of items of the I/O vector.
+     */
+    enc->hdrbuf  = hdrbuf;
+    enc->hdrsize = hdrsize;
+    enc->hdrused = 0;
+    enc->iov     = iov;
+    enc->iovmax  = iovmax;
+    enc->iovcnt  = 0;
+    enc->total   = 0;
+    enc->depth   = 0;
+    enc->failed  = !hdrbuf || !iov;
+}
+//------------------------------------------------------------------------------
+static
+bool push_iov(bertlv_iov_t *enc, const void *data, size_t size)
+{
+    if( !size ) return true;
+
+    struct iovec *last = enc->iovcnt ? &enc->iov[enc->iovcnt-1] : NULL;
+    if( last && last->iov_base && (const uint8_t*)last->iov_base + last->iov_len == data )
+    {
+        last->iov_len += size;
+    }
+    else
+    {
+        if( enc->iovcnt >= enc->iovmax ) return false;
+
+        enc->iov[enc->iovcnt].iov_base = (void*)data;
+        enc->iov[enc->iovcnt].iov_len  = size;
+        ++enc->iovcnt;
+    }
+
+    enc->total += size;
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+uint8_t* write_header(bertlv_iov_t *enc, bertlv_tag_t tag, size_t length, size_t *size)
+{
+    uint8_t *pos  = enc->hdrbuf + enc->hdrused;
+    size_t   rest = enc->hdrsize - enc->hdrused;
+
+    size_t tag_size = bertlv_tag_encode(pos, rest, tag);
+    if( !tag_size ) return NULL;
+
+    size_t len_size = bertlv_len_encode(pos + tag_size, rest - tag_size, length);
+    if( !len_size ) return NULL;
+
+    *size = tag_size + len_size;
+    enc->hdrused += *size;
+
+    return pos;
+}
+//------------------------------------------------------------------------------
+bool bertlv_iov_add(bertlv_iov_t *enc, bertlv_tag_t tag, const void *data, size_t size)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Add a primitive element.
+     *
+     * @param enc  The encoder object.
+     * @param tag  Tag of the element.
+     * @param data Payload data of the element,
+     *             and it will be referred (not copied) until the output is written.
+     * @param size Payload size of the element.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    struct iovec part = { (void*)data, size };
+    return bertlv_iov_add_vec(enc, tag, &part, 1);
+}
+//------------------------------------------------------------------------------
+bool bertlv_iov_add_vec(bertlv_iov_t *enc, bertlv_tag_t tag, const struct iovec *parts, size_t count)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Add a primitive element which payload is spread across several buffers.
+     *
+     * @param enc   The encoder object.
+     * @param tag   Tag of the element.
+     * @param parts Buffers of the payload data, in order.
+     * @param count Number of buffers.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    if( enc->failed ) return false;
+
+    size_t length = 0;
+    for(size_t i=0; i<count; ++i)
+        length += parts[i].iov_len;
+
+    size_t   hdrsize;
+    uint8_t *header = write_header(enc, tag, length, &hdrsize);
+    if( !header || !push_iov(enc, header, hdrsize) )
+    {
+        enc->failed = true;
+        return false;
+    }
+
+    for(size_t i=0; i<count; ++i)
+    {
+        if( !push_iov(enc, parts[i].iov_base, parts[i].iov_len) )
+        {
+            enc->failed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool bertlv_iov_add_raw(bertlv_iov_t *enc, const void *data, size_t size)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Add pre-encoded TLV data.
+     *
+     * @param enc  The encoder object.
+     * @param data The encoded data, it will be referred (not copied).
+     * @param size Size of the encoded data.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    if( enc->failed ) return false;
+
+    if( !push_iov(enc, data, size) )
+    {
+        enc->failed = true;
+        return false;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool bertlv_iov_begin(bertlv_iov_t *enc, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Begin a constructed element.
+     *
+     * @param enc The encoder object.
+     * @param tag Tag of the element.
+     * @return TRUE if succeed; and FALSE if not.
+     *
+     * @remarks A vector item will be reserved for the header,
+     *          and it will be filled on ::bertlv_iov_end.
+     */
+    if( enc->failed ) return false;
+
+    if( enc->depth >= BERTLV_TREE_DEPTH_MAX || enc->iovcnt >= enc->iovmax )
+    {
+        enc->failed = true;
+        return false;
+    }
+
+    enc->iov[enc->iovcnt].iov_base = NULL;
+    enc->iov[enc->iovcnt].iov_len  = 0;
+
+    enc->slots [enc->depth] = enc->iovcnt++;
+    enc->starts[enc->depth] = enc->total;
+    enc->tags  [enc->depth] = tag;
+    ++enc->depth;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool bertlv_iov_end(bertlv_iov_t *enc)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief End the constructed element that was begun last.
+     *
+     * @param enc The encoder object.
+     * @return TRUE if succeed; and FALSE if not.
+     */
+    if( enc->failed ) return false;
+
+    do
+    {
+        if( !enc->depth ) break;
+        --enc->depth;
+
+        size_t   hdrsize;
+        uint8_t *header = write_header(enc,
+                                       enc->tags[enc->depth],
+                                       enc->total - enc->starts[enc->depth],
+                                       &hdrsize);
+        if( !header ) break;
+
+        struct iovec *slot = &enc->iov[enc->slots[enc->depth]];
+        slot->iov_base = header;
+        slot->iov_len  = hdrsize;
+        enc->total    += hdrsize;
+
+        return true;
+    } while(false);
+
+    enc->failed = true;
+    return false;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_iov_finish(const bertlv_iov_t *enc, size_t *iovcnt)
+{
+    /**
+     * @memberof bertlv_iov_t
+     * @brief Get the result of encoding.
+     *
+     * @param enc    The encoder object.
+     * @param iovcnt Receives the number of vector items be used.
+     * @return Total size of the encoded data if succeed; or
+     *         ZERO if any operation failed or some constructed elements are not ended.
+     */
+    if( enc->failed || enc->depth )
+    {
+        *iovcnt = 0;
+        return 0;
+    }
+
+    *iovcnt = enc->iovcnt;
+    return enc->total;
+}
+//------------------------------------------------------------------------------
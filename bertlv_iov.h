@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief     BER-TLV scatter-gather encoder.
+ * @details   Encode TLV data into an I/O vector without copying payload data (POSIX only).
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_IOV_H_
+#define _BERTLV_IOV_H_
+
+#include <sys/uio.h>
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class bertlv_iov_t
+ * @brief Scatter-gather TLV encoder.
+ * @details Only the tag and length fields be written into a small header buffer,
+ *          and the I/O vector refers to the header buffer and the caller's payload buffers,
+ *          so that the result can be passed to `writev` or `sendmsg` directly.
+ *          Adjacent headers will be merged into one vector item.
+ *          The encoder stops working after any failure,
+ *          and ::bertlv_iov_finish will report that.
+ */
+typedef struct bertlv_iov_t
+{
+    uint8_t      *hdrbuf;
+    size_t        hdrsize;
+    size_t        hdrused;
+
+    struct iovec *iov;
+    size_t        iovmax;
+    size_t        iovcnt;
+
+    size_t        total;
+    size_t        slots [BERTLV_TREE_DEPTH_MAX];
+    size_t        starts[BERTLV_TREE_DEPTH_MAX];
+    bertlv_tag_t  tags  [BERTLV_TREE_DEPTH_MAX];
+    unsigned      depth;
+    bool          failed;
+} bertlv_iov_t;
+
+void   bertlv_iov_init(bertlv_iov_t *enc, void *hdrbuf, size_t hdrsize, struct iovec *iov, size_t iovmax);
+bool   bertlv_iov_add(bertlv_iov_t *enc, bertlv_tag_t tag, const void *data, size_t size);
+bool   bertlv_iov_add_vec(bertlv_iov_t *enc, bertlv_tag_t tag, const struct iovec *parts, size_t count);
+bool   bertlv_iov_add_raw(bertlv_iov_t *enc, const void *data, size_t size);
+bool   bertlv_iov_begin(bertlv_iov_t *enc, bertlv_tag_t tag);
+bool   bertlv_iov_end(bertlv_iov_t *enc);
+size_t bertlv_iov_finish(const bertlv_iov_t *enc, size_t *iovcnt);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+#include <pthread.h>
+#include <stdint.h>
+#include "bertlv_par.h"
+
+/*
+ * A job searches this number of bytes at most for its first element boundary,
+ * and a candidate boundary be accepted if this number of elements can be decoded from it.
+ */
+#define RESYNC_WINDOW 4096
+#define RESYNC_CHECKS 8
+
+typedef struct job_t job_t;
+typedef bool(*job_op_t)(job_t *job, const void *tlv, const bertlv_header_t *header);
+
+struct job_t
+{
+    const uint8_t  *group;
+    size_t          size;
+    size_t          begin;      // The byte range, and the job owns
+    size_t          end;        // the elements that start in it.
+    unsigned        id;
+    size_t         *first_found;
+
+    size_t          start;      // The first element boundary, or SIZE_MAX if not found.
+    size_t          stop;       // Where the walk stopped.
+    int             err;
+    bool            cancelled;
+
+    job_op_t        op;
+    bertlv_par_cb_t callback;
+    void           *arg;
+    bertlv_tag_t    tag;
+
+    size_t          index;
+    size_t          count;
+    const void     *found;
+};
+
+//------------------------------------------------------------------------------
+static
+bool resync_check(const uint8_t *group, size_t size, size_t pos)
+{
+    for(unsigned i=0; i<RESYNC_CHECKS && pos<size; ++i)
+    {
+        bertlv_header_t header;
+        if( bertlv_decode_header_s(group + pos, size - pos, &header) ) return false;
+
+        pos += header.total_size;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+size_t job_resync(const job_t *job)
+{
+    // Guess the first element boundary in the range,
+    // and it will be verified by the end of the previous job later.
+    if( !job->begin ) return 0;
+
+    size_t limit = ( job->end - job->begin > RESYNC_WINDOW )?( job->begin + RESYNC_WINDOW ):( job->end );
+    for(size_t pos = job->begin; pos < limit; ++pos)
+    {
+        if( resync_check(job->group, job->size, pos) ) return pos;
+    }
+
+    return SIZE_MAX;
+}
+//------------------------------------------------------------------------------
+static
+void job_walk(job_t *job, size_t pos, bool cancellable)
+{
+    job->err       = BERTLV_OK;
+    job->cancelled = false;
+
+    while( pos < job->end )
+    {
+        // Stop if an earlier job has found what we are looking for.
+        if( cancellable && __atomic_load_n(job->first_found, __ATOMIC_RELAXED) < job->id )
+        {
+            job->cancelled = true;
+            break;
+        }
+
+        bertlv_header_t header;
+        int err = bertlv_decode_header_s(job->group + pos, job->size - pos, &header);
+        if( err )
+        {
+            job->err = err;
+            break;
+        }
+
+        bool more = job->op(job, job->group + pos, &header);
+        ++job->index;
+        pos += header.total_size;
+
+        if( !more ) break;
+    }
+
+    job->stop = pos;
+}
+//------------------------------------------------------------------------------
+static
+void* job_run(void *arg)
+{
+    job_t *job = arg;
+
+    job->start = job_resync(job);
+    if( job->start != SIZE_MAX )
+        job_walk(job, job->start, true);
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void* job_rerun(void *arg)
+{
+    job_t *job = arg;
+    job_walk(job, job->start, false);
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void run_threads(job_t *jobs, unsigned njobs, void*(*func)(void*))
+{
+    // The first job runs on the calling thread,
+    // and also the jobs that a thread cannot be created for.
+    pthread_t ids[BERTLV_PAR_THREADS_MAX];
+    bool      started[BERTLV_PAR_THREADS_MAX] = {false};
+    for(unsigned i=1; i<njobs; ++i)
+        started[i] = !pthread_create(&ids[i], NULL, func, &jobs[i]);
+
+    func(&jobs[0]);
+    for(unsigned i=1; i<njobs; ++i)
+    {
+        if( started[i] )
+            pthread_join(ids[i], NULL);
+        else
+            func(&jobs[i]);
+    }
+}
+//------------------------------------------------------------------------------
+static
+unsigned settle_jobs(job_t *jobs, unsigned njobs)
+{
+    // Verify the boundary guessed by each job with the end of the previous one,
+    // and redo the jobs that started at a wrong place (or be cancelled) sequentially.
+    // Return the number of jobs that have part of the result.
+    size_t pos = 0;
+    for(unsigned i=0; i<njobs; ++i)
+    {
+        job_t *job = &jobs[i];
+
+        if( job->start != pos )
+        {
+            job->start = pos;
+            job->count = 0;
+            job->found = NULL;
+            job_walk(job, pos, false);
+        }
+        else if( job->cancelled )
+        {
+            job_walk(job, job->stop, false);
+        }
+
+        if( job->found || job->err ) return i + 1;
+        pos = job->stop;
+    }
+
+    return njobs;
+}
+//------------------------------------------------------------------------------
+static
+unsigned run_jobs(const void *group, size_t size, unsigned threads, const job_t *proto, job_t *jobs, size_t *first_found)
+{
+    if( threads < 1 ) threads = 1;
+    if( threads > BERTLV_PAR_THREADS_MAX ) threads = BERTLV_PAR_THREADS_MAX;
+    if( threads > size ) threads = size ? size : 1;
+
+    *first_found = SIZE_MAX;
+
+    for(unsigned i=0; i<threads; ++i)
+    {
+        jobs[i]             = *proto;
+        jobs[i].group       = group;
+        jobs[i].size        = size;
+        jobs[i].begin       = size * i / threads;
+        jobs[i].end         = size * ( i + 1 ) / threads;
+        jobs[i].id          = i;
+        jobs[i].first_found = first_found;
+    }
+
+    run_threads(jobs, threads, job_run);
+    return settle_jobs(jobs, threads);
+}
+//------------------------------------------------------------------------------
+static
+bool op_count_all(job_t *job, const void *tlv, const bertlv_header_t *header)
+{
+    ++job->count;
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+bool op_callback(job_t *job, const void *tlv, const bertlv_header_t *header)
+{
+    job->callback(job->arg, tlv, header, job->index);
+    return true;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_par_scan(const void *group, size_t size, unsigned threads, bertlv_par_cb_t callback, void *arg)
+{
+    /**
+     * Call a function for each TLV element of a group with multiple threads.
+     *
+     * @param group    The set of raw data of TLV elements.
+     * @param size     Size of the input data.
+     * @param threads  Number of threads to be used, including the calling thread.
+     * @param callback The function to be called for each element.
+     * @param arg      An user argument that will be passed to the callback.
+     * @return The number of TLV elements be processed.
+     *
+     * @remarks The group be split into equal-sized byte ranges for the threads,
+     *          and each thread finds the first element boundary in its range by a bounded search.
+     *          The elements be counted in parallel first to verify the boundaries
+     *          and to know the element indexes, and then the callback be called in parallel.
+     *          The ranges with a wrong boundary will be processed on the calling thread.
+     */
+    job_t    proto = { .op = op_count_all };
+    job_t    jobs[BERTLV_PAR_THREADS_MAX];
+    size_t   first_found;
+    unsigned njobs = run_jobs(group, size, threads, &proto, jobs, &first_found);
+
+    size_t count = 0;
+    for(unsigned i=0; i<njobs; ++i)
+    {
+        jobs[i].op       = op_callback;
+        jobs[i].callback = callback;
+        jobs[i].arg      = arg;
+        jobs[i].index    = count;
+
+        count += jobs[i].count;
+    }
+
+    run_threads(jobs, njobs, job_rerun);
+
+    return count;
+}
+//------------------------------------------------------------------------------
+static
+bool op_count(job_t *job, const void *tlv, const bertlv_header_t *header)
+{
+    if( header->tag == job->tag ) ++job->count;
+    return true;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_par_count(const void *group, size_t size, unsigned threads, bertlv_tag_t tag)
+{
+    /**
+     * Count TLV elements with a specific tag in a group with multiple threads.
+     *
+     * @param group   The set of raw data of TLV elements.
+     * @param size    Size of the input data.
+     * @param threads Number of threads to be used, including the calling thread.
+     * @param tag     Tag of the elements to be counted.
+     * @return The number of TLV elements with the tag.
+     */
+    job_t    proto = { .op = op_count, .tag = tag };
+    job_t    jobs[BERTLV_PAR_THREADS_MAX];
+    size_t   first_found;
+    unsigned njobs = run_jobs(group, size, threads, &proto, jobs, &first_found);
+
+    size_t count = 0;
+    for(unsigned i=0; i<njobs; ++i)
+        count += jobs[i].count;
+
+    return count;
+}
+//------------------------------------------------------------------------------
+static
+bool op_find(job_t *job, const void *tlv, const bertlv_header_t *header)
+{
+    if( header->tag != job->tag ) return true;
+
+    job->found = tlv;
+
+    // Let the later jobs stop.
+    size_t first = __atomic_load_n(job->first_found, __ATOMIC_RELAXED);
+    while( job->id < first &&
+           !__atomic_compare_exchange_n(job->first_found, &first, job->id,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+    {}
+
+    return false;
+}
+//------------------------------------------------------------------------------
+const void* bertlv_par_find(const void *group, size_t size, unsigned threads, bertlv_tag_t tag)
+{
+    /**
+     * Find the first TLV element with a specific tag in a group with multiple threads.
+     *
+     * @param group   The set of raw data of TLV elements.
+     * @param size    Size of the input data.
+     * @param threads Number of threads to be used, including the calling thread.
+     * @param tag     Tag of the specific TLV element.
+     * @return The first TLV element (in order of the group) with the tag if found; or
+     *         NULL if not found.
+     *
+     * @remarks Once a match be found, the threads working on the later ranges stop.
+     */
+    job_t    proto = { .op = op_find, .tag = tag };
+    job_t    jobs[BERTLV_PAR_THREADS_MAX];
+    size_t   first_found;
+    unsigned njobs = run_jobs(group, size, threads, &proto, jobs, &first_found);
+
+    return jobs[njobs-1].found;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,42 @@
+/**
+ * @file
+ * @brief     Parallel BER-TLV group scanner.
+ * @details   Multi-threaded processing of large TLV groups (POSIX threads).
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_PAR_H_
+#define _BERTLV_PAR_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum number of threads that the parallel functions will use.
+ */
+#define BERTLV_PAR_THREADS_MAX 64
+
+/**
+ * Callback of ::bertlv_par_scan.
+ *
+ * @param arg    The user argument.
+ * @param tlv    The TLV element.
+ * @param header Header of the TLV element.
+ * @param index  Index of the TLV element in the group.
+ *
+ * @remarks The callback will be called from several threads concurrently,
+ *          and the elements of each thread are in order of the group.
+ */
+typedef void(*bertlv_par_cb_t)(void *arg, const void *tlv, const bertlv_header_t *header, size_t index);
+
+size_t      bertlv_par_scan(const void *group, size_t size, unsigned threads, bertlv_par_cb_t callback, void *arg);
+size_t      bertlv_par_count(const void *group, size_t size, unsigned threads, bertlv_tag_t tag);
+const void* bertlv_par_find(const void *group, size_t size, unsigned threads, bertlv_tag_t tag);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
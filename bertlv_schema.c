@@ -0,0 +1,371 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bertlv_schema.h"
+
+//------------------------------------------------------------------------------
+static
+int slot_compare(const void *a, const void *b)
+{
+    const bertlv_schema_slot_t *slot1 = a;
+    const bertlv_schema_slot_t *slot2 = b;
+    return ( slot1->tag < slot2->tag )?( -1 ):( slot1->tag > slot2->tag );
+}
+//------------------------------------------------------------------------------
+bool bertlv_schema_compile(bertlv_schema_t             *schema,
+                           const bertlv_schema_field_t *fields,
+                           size_t                       count,
+                           bertlv_schema_slot_t        *slots)
+{
+    /**
+     * @memberof bertlv_schema_t
+     * @brief Compile field definitions into a schema.
+     *
+     * @param schema The schema object.
+     * @param fields The field definitions,
+     *               and they must stay unchanged while the schema is in use.
+     * @param count  Number of fields.
+     * @param slots  Storage of the lookup table, with @a count items.
+     * @return TRUE if succeed; and
+     *         FALSE if there are too many fields, some fields have the same tag,
+     *         some fields have an unknown storage kind, or
+     *         ::BERTLV_FIELD_UINT and ::BERTLV_FIELD_BYTES fields have constructed tags.
+     */
+    if( count > BERTLV_SCHEMA_FIELDS_MAX ) return false;
+
+    for(size_t i=0; i<count; ++i)
+    {
+        if( fields[i].kind < BERTLV_FIELD_VALUE || fields[i].kind > BERTLV_FIELD_BYTES )
+            return false;
+
+        // Only the payload of primitive elements can be a number or bytes.
+        if( fields[i].kind != BERTLV_FIELD_VALUE &&
+            bertlv_tag_get_type(fields[i].tag) == BERTLV_TYPE_CONSTRUCTED )
+            return false;
+
+        slots[i].tag   = fields[i].tag;
+        slots[i].field = i;
+    }
+
+    qsort(slots, count, sizeof(slots[0]), slot_compare);
+
+    for(size_t i=1; i<count; ++i)
+    {
+        if( slots[i-1].tag == slots[i].tag )
+            return false;
+    }
+
+    schema->fields = fields;
+    schema->slots  = slots;
+    schema->count  = count;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+const bertlv_schema_slot_t* schema_lookup(const bertlv_schema_t *schema, bertlv_tag_t tag)
+{
+    size_t lo = 0;
+    size_t hi = schema->count;
+    while( lo < hi )
+    {
+        size_t mid = lo + ( hi - lo ) / 2;
+        if( schema->slots[mid].tag < tag )
+            lo = mid + 1;
+        else if( schema->slots[mid].tag > tag )
+            hi = mid;
+        else
+            return &schema->slots[mid];
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void field_clear(const bertlv_schema_field_t *field, uint8_t *obj)
+{
+    switch( field->kind )
+    {
+    case BERTLV_FIELD_VALUE:
+        {
+            bertlv_value_t value = { NULL, 0 };
+            memcpy(obj + field->offset, &value, sizeof(value));
+        }
+        break;
+
+    case BERTLV_FIELD_UINT:
+        {
+            uint64_t value = 0;
+            memcpy(obj + field->offset, &value, sizeof(value));
+        }
+        break;
+
+    case BERTLV_FIELD_BYTES:
+        memset(obj + field->offset, 0, field->max_len);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool field_store(const bertlv_schema_field_t *field, uint8_t *obj, const bertlv_header_t *header)
+{
+    if( header->length < field->min_len || header->length > field->max_len ) return false;
+
+    switch( field->kind )
+    {
+    case BERTLV_FIELD_VALUE:
+        {
+            bertlv_value_t value = { header->value, header->length };
+            memcpy(obj + field->offset, &value, sizeof(value));
+        }
+        return true;
+
+    case BERTLV_FIELD_UINT:
+        {
+            if( header->length > sizeof(uint64_t) ) return false;
+
+            const uint8_t *data  = header->value;
+            uint64_t       value = 0;
+            for(size_t i=0; i<header->length; ++i)
+                value = ( value << 8 ) | data[i];
+
+            memcpy(obj + field->offset, &value, sizeof(value));
+        }
+        return true;
+
+    case BERTLV_FIELD_BYTES:
+        memcpy(obj + field->offset, header->value, header->length);
+        memset(obj + field->offset + header->length, 0, field->max_len - header->length);
+        return true;
+
+    default:
+        return false;
+    }
+}
+//------------------------------------------------------------------------------
+int bertlv_decode_schema(const bertlv_schema_t *schema,
+                         const void            *group,
+                         size_t                 size,
+                         void                  *obj,
+                         uint8_t               *status)
+{
+    /**
+     * @memberof bertlv_schema_t
+     * @brief Decode a group of TLV data into a structure in one pass.
+     *
+     * @param schema The compiled schema.
+     * @param group  The set of raw data of TLV elements,
+     *               and elements nested in constructed elements will be decoded too.
+     * @param size   Size of the input data.
+     * @param obj    The structure to be filled.
+     * @param status An array to receive the status of each field
+     *               (::bertlv_field_status_t, in order of the field definitions),
+     *               and it can be NULL if not needed.
+     * @return ::BERTLV_OK if all required fields be found and no invalid fields; or
+     *         ::BERTLV_ERR_INVALID_FIELD if any element has an invalid length; or
+     *         ::BERTLV_ERR_MISSING_FIELD if any required element is not found; or
+     *         other ::bertlv_error_t values if the group has malformed elements.
+     *
+     * @remarks Only the first element will be stored if a tag appears several times,
+     *          and fields not be found or invalid will be set to zero.
+     *          Fields of the ::BERTLV_FIELD_VALUE kind refer to the input data directly.
+     */
+    if( !schema->count ) return BERTLV_OK;
+
+    uint64_t seen [BERTLV_SCHEMA_FIELDS_MAX/64] = {0};
+    uint64_t found[BERTLV_SCHEMA_FIELDS_MAX/64] = {0};
+    bool     invalid = false;
+
+    bertlv_tree_iter_t iter;
+    bertlv_tree_iter_init(&iter, group, size);
+
+    bertlv_tag_t tag_min = schema->slots[0].tag;
+    bertlv_tag_t tag_max = schema->slots[schema->count-1].tag;
+
+    bertlv_header_t header;
+    while( bertlv_tree_iter_get_next(&iter, &header) )
+    {
+        if( header.tag < tag_min || header.tag > tag_max ) continue;
+
+        const bertlv_schema_slot_t *slot = schema_lookup(schema, header.tag);
+        if( !slot ) continue;
+
+        size_t   index = slot->field;
+        uint64_t bit   = (uint64_t)1 << ( index % 64 );
+        if( seen[ index / 64 ] & bit ) continue;
+        seen[ index / 64 ] |= bit;
+
+        if( field_store(&schema->fields[index], obj, &header) )
+            found[ index / 64 ] |= bit;
+        else
+            invalid = true;
+    }
+
+    int  err     = bertlv_tree_iter_get_error(&iter);
+    bool missing = false;
+    for(size_t i=0; i<schema->count; ++i)
+    {
+        const bertlv_schema_field_t *field = &schema->fields[i];
+
+        uint64_t bit = (uint64_t)1 << ( i % 64 );
+        if( !( found[ i / 64 ] & bit ) )
+            field_clear(field, obj);
+
+        if( !( seen[ i / 64 ] & bit ) && field->required )
+            missing = true;
+
+        if( status )
+        {
+            status[i] = ( found[ i / 64 ] & bit )?( BERTLV_FIELD_FOUND ):
+                        ( seen [ i / 64 ] & bit )?( BERTLV_FIELD_INVALID ):( BERTLV_FIELD_MISSING );
+        }
+    }
+
+    return err     ? err :
+           invalid ? BERTLV_ERR_INVALID_FIELD :
+           missing ? BERTLV_ERR_MISSING_FIELD : BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+bool bertlv_plan_compile(bertlv_plan_t               *plan,
+                         const bertlv_schema_field_t *fields,
+                         size_t                       count,
+                         bertlv_plan_item_t          *items)
+{
+    /**
+     * @memberof bertlv_plan_t
+     * @brief Compile field definitions into an encoding plan.
+     *
+     * @param plan   The plan object.
+     * @param fields The field definitions,
+     *               and they must stay unchanged while the plan is in use.
+     *               The elements will be encoded in the order of definitions.
+     * @param count  Number of fields, not more than ::BERTLV_PLAN_FIELDS_MAX.
+     * @param items  Storage of the plan items, with @a count items.
+     * @return TRUE if succeed; and
+     *         FALSE if there are too many fields, or some fields have invalid tags
+     *         or an unknown storage kind, or ::BERTLV_FIELD_UINT fields longer than 8 bytes.
+     *
+     * @remarks Fields of ::BERTLV_FIELD_UINT and ::BERTLV_FIELD_BYTES kinds
+     *          will be encoded with payload size of @a max_len,
+     *          and ::BERTLV_FIELD_VALUE fields with the size of the value referred.
+     */
+    if( count > BERTLV_PLAN_FIELDS_MAX ) return false;
+
+    for(size_t i=0; i<count; ++i)
+    {
+        const bertlv_schema_field_t *field = &fields[i];
+        bertlv_plan_item_t          *item  = &items[i];
+
+        if( !bertlv_tag_is_valid(field->tag) ) return false;
+        if( field->kind < BERTLV_FIELD_VALUE || field->kind > BERTLV_FIELD_BYTES ) return false;
+        if( field->kind == BERTLV_FIELD_UINT && field->max_len > sizeof(uint64_t) ) return false;
+
+        item->tag_size    = bertlv_tag_encode(item->header, sizeof(item->header), field->tag);
+        item->header_size = item->tag_size;
+
+        if( field->kind != BERTLV_FIELD_VALUE )
+        {
+            item->header_size += bertlv_len_encode(item->header + item->tag_size,
+                                                   sizeof(item->header) - item->tag_size,
+                                                   field->max_len);
+        }
+    }
+
+    plan->fields = fields;
+    plan->items  = items;
+    plan->count  = count;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_encode_plan(const bertlv_plan_t *plan,
+                          const void          *obj,
+                          uint64_t             present,
+                          void                *buf,
+                          size_t               bufsize)
+{
+    /**
+     * @memberof bertlv_plan_t
+     * @brief Encode fields of a structure into a group of TLV data in one pass.
+     *
+     * @param plan    The compiled plan.
+     * @param obj     The structure to be encoded.
+     * @param present Presence mask of the optional fields,
+     *                bit N for the field N of the definitions.
+     *                Required fields will always be encoded.
+     * @param buf     A buffer to be filled by the encoded data,
+     *                and it can be NULL to calculate buffer size that be needed.
+     * @param bufsize Size of the output buffer.
+     * @return It returns the size of data be filled to the output buffer if succeed; or
+     *         ZERO if the buffer is not large enough or
+     *         the size of some ::BERTLV_FIELD_VALUE field is out of range; or
+     *         The minimum size of output buffer that will be needed if @a buf was NULL.
+     */
+    const uint8_t *src  = obj;
+    uint8_t       *pos  = buf;
+    size_t         size = 0;
+
+    for(size_t i=0; i<plan->count; ++i)
+    {
+        const bertlv_schema_field_t *field = &plan->fields[i];
+        const bertlv_plan_item_t    *item  = &plan->items[i];
+
+        if( !field->required && !( present >> i & 1 ) ) continue;
+
+        const void *data;
+        size_t      length;
+        uint8_t     number[sizeof(uint64_t)];
+        size_t      header_size = item->header_size;
+
+        switch( field->kind )
+        {
+        case BERTLV_FIELD_VALUE:
+            {
+                bertlv_value_t value;
+                memcpy(&value, src + field->offset, sizeof(value));
+                if( value.size < field->min_len || value.size > field->max_len ) return 0;
+
+                data   = value.data;
+                length = value.size;
+                header_size += bertlv_len_encode(NULL, 0, length);
+            }
+            break;
+
+        case BERTLV_FIELD_UINT:
+            {
+                uint64_t value;
+                memcpy(&value, src + field->offset, sizeof(value));
+                for(size_t n = field->max_len; n--; value >>= 8)
+                    number[n] = value & 0xFF;
+
+                data   = number;
+                length = field->max_len;
+            }
+            break;
+
+        default:
+            data   = src + field->offset;
+            length = field->max_len;
+            break;
+        }
+
+        size_t total = header_size + length;
+        if( !buf )
+        {
+            size += total;
+            continue;
+        }
+
+        if( bufsize - size < total ) return 0;
+
+        memcpy(pos, item->header, item->header_size);
+        if( field->kind == BERTLV_FIELD_VALUE )
+            bertlv_len_encode(pos + item->tag_size, header_size - item->tag_size, length);
+        if( length ) memcpy(pos + header_size, data, length);
+
+        pos  += total;
+        size += total;
+    }
+
+    return size;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief     BER-TLV schema binding.
+ * @details   Bind a dictionary of tags to fields of a C structure,
+ *            and decode all of them in one pass.
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_SCHEMA_H_
+#define _BERTLV_SCHEMA_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Storage kinds of schema fields.
+ */
+enum bertlv_field_kind_t
+{
+    BERTLV_FIELD_VALUE  = 0,    ///< A ::bertlv_value_t that refers to the payload in the input data.
+    BERTLV_FIELD_UINT   = 1,    ///< An `uint64_t` decoded from big-endian payload (8 bytes at most).
+    BERTLV_FIELD_BYTES  = 2,    ///< An `uint8_t` array of `max_len` bytes, the payload be copied and zero padded.
+};
+
+/**
+ * Decoding status of schema fields.
+ */
+enum bertlv_field_status_t
+{
+    BERTLV_FIELD_MISSING    = 0,    ///< The element is not found.
+    BERTLV_FIELD_FOUND      = 1,    ///< The element is found and stored.
+    BERTLV_FIELD_INVALID    = 2,    ///< The element is found, but its length is out of range.
+};
+
+/**
+ * Reference to a payload data.
+ */
+typedef struct bertlv_value_t
+{
+    const void *data;   ///< The payload data.
+    size_t      size;   ///< Size of the payload data.
+} bertlv_value_t;
+
+/**
+ * Maximum number of fields of a schema.
+ */
+#define BERTLV_SCHEMA_FIELDS_MAX 256
+
+/**
+ * Definition of a schema field.
+ */
+typedef struct bertlv_schema_field_t
+{
+    bertlv_tag_t tag;       ///< Tag of the element.
+    size_t       offset;    ///< Offset of the field in the structure (by `offsetof`).
+    int          kind;      ///< Storage kind of the field, one of ::bertlv_field_kind_t.
+    size_t       min_len;   ///< Minimum payload size.
+    size_t       max_len;   ///< Maximum payload size.
+    bool         required;  ///< If the element must be present.
+} bertlv_schema_field_t;
+
+/**
+ * Lookup slot of a compiled schema.
+ */
+typedef struct bertlv_schema_slot_t
+{
+    bertlv_tag_t tag;
+    size_t       field;
+} bertlv_schema_slot_t;
+
+/**
+ * @class bertlv_schema_t
+ * @brief Compiled schema.
+ * @details The field definitions compiled into a tag-sorted lookup table,
+ *          which is stored in caller-provided memory.
+ */
+typedef struct bertlv_schema_t
+{
+    const bertlv_schema_field_t *fields;
+    bertlv_schema_slot_t        *slots;
+    size_t                       count;
+} bertlv_schema_t;
+
+bool bertlv_schema_compile(bertlv_schema_t             *schema,
+                           const bertlv_schema_field_t *fields,
+                           size_t                       count,
+                           bertlv_schema_slot_t        *slots);
+
+int bertlv_decode_schema(const bertlv_schema_t *schema,
+                         const void            *group,
+                         size_t                 size,
+                         void                  *obj,
+                         uint8_t               *status);
+
+/**
+ * Maximum number of fields of an encoding plan (limited by the presence mask).
+ */
+#define BERTLV_PLAN_FIELDS_MAX 64
+
+/**
+ * Item of an encoding plan.
+ */
+typedef struct bertlv_plan_item_t
+{
+    uint8_t header[sizeof(bertlv_tag_t)+1+sizeof(size_t)];
+    uint8_t header_size;
+    uint8_t tag_size;
+} bertlv_plan_item_t;
+
+/**
+ * @class bertlv_plan_t
+ * @brief Compiled encoding plan.
+ * @details The field definitions with pre-encoded tags
+ *          (and the whole headers of fixed-size fields),
+ *          which are stored in caller-provided memory.
+ */
+typedef struct bertlv_plan_t
+{
+    const bertlv_schema_field_t *fields;
+    bertlv_plan_item_t          *items;
+    size_t                       count;
+} bertlv_plan_t;
+
+bool   bertlv_plan_compile(bertlv_plan_t               *plan,
+                           const bertlv_schema_field_t *fields,
+                           size_t                       count,
+                           bertlv_plan_item_t          *items);
+size_t bertlv_encode_plan(const bertlv_plan_t *plan,
+                          const void          *obj,
+                          uint64_t             present,
+                          void                *buf,
+                          size_t               bufsize);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief     BER-TLV parsing statistics.
+ * @details   Optional instrumentation of the parsers, be enabled by defining `BERTLV_STATS`
+ *            when the library is compiled, and it costs nothing if not enabled.
+ * @copyright ZLib Licence
+ *
+ * Besides the global counters, an user can define the following macros in a header,
+ * and give its name by `BERTLV_STATS_HOOKS` (e.g. `-DBERTLV_STATS_HOOKS='"my_hooks.h"'`)
+ * to receive every event on each call site:
+ *
+ * * `BERTLV_HOOK_ELEMENT(site, size, depth)`: An element of @a size bytes be parsed.
+ * * `BERTLV_HOOK_ERROR(site, err)`: Parsing failed with an ::bertlv_error_t code.
+ *
+ * where @a site is a string literal that names the parser,
+ * such as "iter", "tree", "scan" and "stream".
+ */
+#ifndef _BERTLV_STATS_H_
+#define _BERTLV_STATS_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of failure counters, indexed by ::bertlv_error_t values.
+ */
+#define BERTLV_STATS_ERRORS 16
+
+/**
+ * Statistics of the parsers.
+ */
+typedef struct bertlv_stats_t
+{
+    uint64_t elements;                      ///< Number of elements be parsed.
+    uint64_t bytes;                         ///< Total size of elements be parsed (nested elements are also counted in their parents).
+    uint64_t failures[BERTLV_STATS_ERRORS]; ///< Number of failures by reason, indexed by ::bertlv_error_t values.
+    unsigned max_depth;                     ///< Maximum nesting depth that be reached.
+} bertlv_stats_t;
+
+#ifdef BERTLV_STATS
+
+extern bertlv_stats_t bertlv_stats_counters;
+
+void bertlv_stats_get(bertlv_stats_t *stats);
+void bertlv_stats_reset(void);
+
+static inline
+void bertlv_stats_on_element(size_t size)
+{
+    __atomic_fetch_add(&bertlv_stats_counters.elements, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bertlv_stats_counters.bytes, size, __ATOMIC_RELAXED);
+}
+
+static inline
+void bertlv_stats_on_depth(unsigned depth)
+{
+    unsigned max = __atomic_load_n(&bertlv_stats_counters.max_depth, __ATOMIC_RELAXED);
+    while( depth > max &&
+           !__atomic_compare_exchange_n(&bertlv_stats_counters.max_depth, &max, depth,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+    {}
+}
+
+static inline
+void bertlv_stats_on_error(int err)
+{
+    if( err > 0 && err < BERTLV_STATS_ERRORS )
+        __atomic_fetch_add(&bertlv_stats_counters.failures[err], 1, __ATOMIC_RELAXED);
+}
+
+#ifdef BERTLV_STATS_HOOKS
+#include BERTLV_STATS_HOOKS
+#endif
+
+#ifndef BERTLV_HOOK_ELEMENT
+#define BERTLV_HOOK_ELEMENT(site, size, depth) ((void)0)
+#endif
+
+#ifndef BERTLV_HOOK_ERROR
+#define BERTLV_HOOK_ERROR(site, err) ((void)0)
+#endif
+
+#define BERTLV_STATS_ELEMENT(site, size, depth) \
+    do { bertlv_stats_on_element(size); bertlv_stats_on_depth(depth); BERTLV_HOOK_ELEMENT(site, size, depth); } while(0)
+#define BERTLV_STATS_ERROR(site, err) \
+    do { bertlv_stats_on_error(err); BERTLV_HOOK_ERROR(site, err); } while(0)
+
+#else
+
+#define BERTLV_STATS_ELEMENT(site, size, depth) ((void)0)
+#define BERTLV_STATS_ERROR(site, err)           ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+#include "bertlv_stream.h"
+#include "bertlv_stats.h"
+
+enum
+{
+    STATE_TAG_FIRST,
+    STATE_TAG_MORE,
+    STATE_LEN_FIRST,
+    STATE_LEN_MORE,
+    STATE_VALUE,
+    STATE_EOC,
+};
+
+static const uint8_t tag_mask_first         = 0x1F;
+static const uint8_t tag_mask_constructed   = 0x20;
+static const uint8_t tag_mask_more          = 0x80;
+static const uint8_t len_mask_long_format   = 0x80;
+
+//------------------------------------------------------------------------------
+void bertlv_stream_init(bertlv_stream_t *stream, bertlv_stream_cb_t callback, void *arg)
+{
+    /**
+     * @memberof bertlv_stream_t
+     * @brief Constructor.
+     *
+     * @param stream   The parser it self.
+     * @param callback The event handler.
+     * @param arg      An user argument that will be passed to the event handler.
+     */
+    stream->callback   = callback;
+    stream->arg        = arg;
+    stream->state      = STATE_TAG_FIRST;
+    stream->indefinite = false;
+    stream->offset     = 0;
+    stream->start      = 0;
+    stream->depth      = 0;
+    stream->err        = BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+static
+bool bertlv_stream_emit(bertlv_stream_t *stream, int type, const void *data, size_t size)
+{
+    bertlv_event_t event =
+    {
+        .type        = type,
+        .depth       = stream->depth,
+        .tag         = stream->tag,
+        .constructed = stream->constructed,
+        .length      = stream->length,
+        .indefinite  = stream->indefinite,
+        .data        = data,
+        .size        = size,
+    };
+
+    return stream->callback(stream->arg, &event);
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_stream_close_level(bertlv_stream_t *stream)
+{
+    --stream->depth;
+
+    bertlv_event_t event =
+    {
+        .type        = BERTLV_EVENT_END,
+        .depth       = stream->depth,
+        .tag         = stream->tags[stream->depth],
+        .constructed = true,
+        .indefinite  = stream->eocs[stream->depth],
+    };
+
+    return stream->callback(stream->arg, &event) ? BERTLV_OK : BERTLV_ERR_ABORTED;
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_stream_close_levels(bertlv_stream_t *stream)
+{
+    // Close all definite length elements that end at the current offset,
+    // and the indefinite ones be closed by end-of-contents only.
+    while( stream->depth &&
+           !stream->eocs[stream->depth-1] &&
+           stream->ends[stream->depth-1] == stream->offset )
+    {
+        int err = bertlv_stream_close_level(stream);
+        if( err ) return err;
+    }
+
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_stream_on_header(bertlv_stream_t *stream)
+{
+    if( stream->depth &&
+        stream->length > stream->ends[stream->depth-1] - stream->offset )
+    {
+        return BERTLV_ERR_OVERRUN;
+    }
+
+    BERTLV_STATS_ELEMENT("stream", stream->offset - stream->start + stream->length, stream->depth);
+
+    if( !bertlv_stream_emit(stream, BERTLV_EVENT_LENGTH, NULL, 0) ) return BERTLV_ERR_ABORTED;
+
+    if( stream->constructed )
+    {
+        if( stream->depth >= BERTLV_TREE_DEPTH_MAX ) return BERTLV_ERR_TOO_DEEP;
+
+        // An indefinite length element is bounded by its parent only.
+        stream->ends[stream->depth] = !stream->indefinite ? stream->offset + stream->length :
+                                      stream->depth ? stream->ends[stream->depth-1] : UINT64_MAX;
+        stream->tags[stream->depth] = stream->tag;
+        stream->eocs[stream->depth] = stream->indefinite;
+        ++stream->depth;
+
+        stream->state = STATE_TAG_FIRST;
+        return bertlv_stream_close_levels(stream);
+    }
+
+    if( !stream->length )
+    {
+        stream->state = STATE_TAG_FIRST;
+        return bertlv_stream_close_levels(stream);
+    }
+
+    stream->value_rest = stream->length;
+    stream->state      = STATE_VALUE;
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+static
+int bertlv_stream_put_header_byte(bertlv_stream_t *stream, uint8_t byte)
+{
+    if( stream->depth && stream->offset >= stream->ends[stream->depth-1] )
+        return BERTLV_ERR_OVERRUN;
+
+    ++stream->offset;
+
+    switch( stream->state )
+    {
+    case STATE_TAG_FIRST:
+        if( !byte && stream->depth && stream->eocs[stream->depth-1] )
+        {
+            stream->state = STATE_EOC;
+            return BERTLV_OK;
+        }
+
+        if( !byte ) return BERTLV_ERR_NULL_TAG;
+
+        stream->start       = stream->offset - 1;
+        stream->tag         = byte;
+        stream->tag_size    = 1;
+        stream->constructed = byte & tag_mask_constructed;
+
+        if( ( byte & tag_mask_first ) == tag_mask_first )
+        {
+            stream->state = STATE_TAG_MORE;
+            return BERTLV_OK;
+        }
+
+        stream->state = STATE_LEN_FIRST;
+        return bertlv_stream_emit(stream, BERTLV_EVENT_TAG, NULL, 0) ? BERTLV_OK : BERTLV_ERR_ABORTED;
+
+    case STATE_TAG_MORE:
+        if( stream->tag_size >= sizeof(bertlv_tag_t) ) return BERTLV_ERR_TAG_TOO_LONG;
+
+        stream->tag <<= 8;
+        stream->tag  |= byte;
+        ++stream->tag_size;
+
+        if( byte & tag_mask_more ) return BERTLV_OK;
+
+        stream->state = STATE_LEN_FIRST;
+        return bertlv_stream_emit(stream, BERTLV_EVENT_TAG, NULL, 0) ? BERTLV_OK : BERTLV_ERR_ABORTED;
+
+    case STATE_LEN_FIRST:
+        stream->indefinite = false;
+
+        if( !( byte & len_mask_long_format ) )
+        {
+            stream->length = byte;
+            return bertlv_stream_on_header(stream);
+        }
+
+        if( byte == len_mask_long_format )
+        {
+            if( !stream->constructed ) return BERTLV_ERR_BAD_LENGTH;
+
+            stream->indefinite = true;
+            stream->length     = 0;
+            return bertlv_stream_on_header(stream);
+        }
+
+        stream->len_rest = byte & ~len_mask_long_format;
+        if( stream->len_rest == 0 || stream->len_rest == 0x7F ) return BERTLV_ERR_BAD_LENGTH;
+        if( stream->len_rest > sizeof(uint64_t) ) return BERTLV_ERR_LENGTH_TOO_LONG;
+
+        stream->length = 0;
+        stream->state  = STATE_LEN_MORE;
+        return BERTLV_OK;
+
+    case STATE_LEN_MORE:
+        stream->length <<= 8;
+        stream->length  |= byte;
+
+        if( --stream->len_rest ) return BERTLV_OK;
+        return bertlv_stream_on_header(stream);
+
+    case STATE_EOC:
+        {
+            if( byte ) return BERTLV_ERR_BAD_LENGTH;
+
+            stream->state = STATE_TAG_FIRST;
+
+            int err = bertlv_stream_close_level(stream);
+            return err ? err : bertlv_stream_close_levels(stream);
+        }
+
+    default:
+        return BERTLV_OK;
+    }
+}
+//------------------------------------------------------------------------------
+int bertlv_stream_feed(bertlv_stream_t *stream, const void *data, size_t size)
+{
+    /**
+     * @memberof bertlv_stream_t
+     * @brief Feed a fragment of TLV data to the parser.
+     *
+     * @param stream The parser object.
+     * @param data   The data fragment.
+     * @param size   Size of the data fragment, and it can be any size.
+     * @return ::BERTLV_OK if succeed; or
+     *         one of ::bertlv_error_t values if the data is malformed or
+     *         the event handler aborted the parsing.
+     *         The parser will refuse further data after any error.
+     */
+    if( stream->err ) return stream->err;
+
+    const uint8_t *pos = data;
+    while( size )
+    {
+        if( stream->state != STATE_VALUE )
+        {
+            int err = bertlv_stream_put_header_byte(stream, *pos);
+            if( err )
+            {
+                BERTLV_STATS_ERROR("stream", err);
+                return stream->err = err;
+            }
+
+            ++pos;
+            --size;
+            continue;
+        }
+
+        size_t chunk = ( stream->value_rest < size )?( stream->value_rest ):( size );
+        stream->offset     += chunk;
+        stream->value_rest -= chunk;
+
+        if( !bertlv_stream_emit(stream, BERTLV_EVENT_VALUE, pos, chunk) )
+            return stream->err = BERTLV_ERR_ABORTED;
+
+        pos  += chunk;
+        size -= chunk;
+
+        if( !stream->value_rest )
+        {
+            stream->state = STATE_TAG_FIRST;
+
+            int err = bertlv_stream_close_levels(stream);
+            if( err )
+            {
+                BERTLV_STATS_ERROR("stream", err);
+                return stream->err = err;
+            }
+        }
+    }
+
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+int bertlv_stream_finish(const bertlv_stream_t *stream)
+{
+    /**
+     * @memberof bertlv_stream_t
+     * @brief Check if the data fed ends at an element boundary.
+     *
+     * @param stream The parser object.
+     * @return ::BERTLV_OK if all elements be complete; or
+     *         ::BERTLV_ERR_TRUNCATED if the data ends inside an element; or
+     *         the error that stopped the parser before.
+     */
+    if( stream->err ) return stream->err;
+
+    return ( stream->state == STATE_TAG_FIRST && !stream->depth )?
+           ( BERTLV_OK ):( BERTLV_ERR_TRUNCATED );
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief     Incremental BER-TLV parser.
+ * @details   A push-style parser that accepts TLV data in fragments of any size.
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_STREAM_H_
+#define _BERTLV_STREAM_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Event types of the incremental parser.
+ */
+enum bertlv_event_type_t
+{
+    BERTLV_EVENT_TAG    = 0,    ///< The tag of an element was decoded.
+    BERTLV_EVENT_LENGTH = 1,    ///< The length of an element was decoded (the header is complete).
+    BERTLV_EVENT_VALUE  = 2,    ///< A chunk of payload data of a primitive element.
+    BERTLV_EVENT_END    = 3,    ///< The end of a constructed element.
+};
+
+/**
+ * Event of the incremental parser.
+ */
+typedef struct bertlv_event_t
+{
+    int          type;          ///< Event type, one of ::bertlv_event_type_t.
+    unsigned     depth;         ///< Nesting depth of the element.
+    bertlv_tag_t tag;           ///< Tag of the element.
+    bool         constructed;   ///< If the element is constructed.
+    uint64_t     length;        ///< Payload size of the element (not available on ::BERTLV_EVENT_TAG, and ZERO if indefinite).
+    bool         indefinite;    ///< If the element has indefinite length (not available on ::BERTLV_EVENT_TAG).
+    const void  *data;          ///< The payload data chunk (::BERTLV_EVENT_VALUE only).
+    size_t       size;          ///< Size of the payload data chunk (::BERTLV_EVENT_VALUE only).
+} bertlv_event_t;
+
+/**
+ * Event handler of the incremental parser.
+ *
+ * @param arg   The user argument.
+ * @param event The event information.
+ * @return TRUE to continue parsing; or FALSE to abort it.
+ *
+ * @remarks The payload data chunk refers to the data being fed,
+ *          and it will not be buffered by the parser.
+ */
+typedef bool(*bertlv_stream_cb_t)(void *arg, const bertlv_event_t *event);
+
+/**
+ * @class bertlv_stream_t
+ * @brief Incremental TLV parser.
+ * @details The parser keeps only the state of the header being decoded and
+ *          the ends of the enclosing constructed elements,
+ *          and the payload data will never be buffered.
+ */
+typedef struct bertlv_stream_t
+{
+    bertlv_stream_cb_t callback;
+    void              *arg;
+
+    int          state;
+    bertlv_tag_t tag;
+    size_t       tag_size;
+    bool         constructed;
+    uint64_t     length;
+    size_t       len_rest;
+    uint64_t     value_rest;
+    uint64_t     offset;
+    uint64_t     start;
+
+    bool         indefinite;
+
+    uint64_t     ends[BERTLV_TREE_DEPTH_MAX];
+    bertlv_tag_t tags[BERTLV_TREE_DEPTH_MAX];
+    bool         eocs[BERTLV_TREE_DEPTH_MAX];
+    unsigned     depth;
+
+    int          err;
+} bertlv_stream_t;
+
+void bertlv_stream_init(bertlv_stream_t *stream, bertlv_stream_cb_t callback, void *arg);
+int  bertlv_stream_feed(bertlv_stream_t *stream, const void *data, size_t size);
+int  bertlv_stream_finish(const bertlv_stream_t *stream);
+
+static inline
+uint64_t bertlv_stream_get_offset(const bertlv_stream_t *stream)
+{
+    /**
+     * @memberof bertlv_stream_t
+     * @brief Get the number of bytes be consumed.
+     */
+    return stream->offset;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
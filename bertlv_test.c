@@ -1,6 +1,20 @@
 #include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <string.h>
 #include "bertlv.h"
+#include "bertlv_stream.h"
+#include "bertlv_file.h"
+#include "bertlv_par.h"
+#include "bertlv_schema.h"
+#include "bertlv_iov.h"
+#include "bertlv_dom.h"
+#include "bertlv_view.h"
+#include "bertlv_stats.h"
+
+void test_tlv_hpp(void);  // In bertlv_hpp_test.cpp.
 
 //------------------------------------------------------------------------------
 void test_tags(void)
@@ -158,6 +172,45 @@ void test_tags(void)
         assert( type == bertlv_tag_get_type  (tag) );
         assert( num  == bertlv_tag_get_number(tag) );
     }
+
+    {
+        static const bertlv_tag_t tags[] =
+        {
+            0xA6, 0xBF8619, 0x5E, 0x5F1F, 0x5F817F, 0x9F02, 0xDF8101,
+            0, 0x1F, 0x5F80, 0x5F01FF, 0xA6A6, 0x9F8181,
+        };
+
+        for(size_t i=0; i<sizeof(tags)/sizeof(tags[0]); ++i)
+        {
+            bertlv_tag_t tag = tags[i];
+            assert( bertlv_tag_is_valid   (tag) == bertlv_tag_is_valid_inline   (tag) );
+            assert( bertlv_tag_get_class  (tag) == bertlv_tag_get_class_inline  (tag) );
+            assert( bertlv_tag_get_type   (tag) == bertlv_tag_get_type_inline   (tag) );
+            assert( bertlv_tag_get_number (tag) == bertlv_tag_get_number_inline (tag) );
+        }
+
+        assert( !bertlv_tag_is_valid(0) );
+        assert( !bertlv_tag_is_valid(0x1F) );
+        assert( !bertlv_tag_is_valid(0x5F80) );
+        assert( !bertlv_tag_is_valid(0x5F01FF) );
+        assert( !bertlv_tag_is_valid(0xA6A6) );
+        assert(  bertlv_tag_is_valid(0x9F8101) );
+        assert( 3 == bertlv_tag_get_size_inline(0x9F8101) );
+        assert( 0x9F == bertlv_tag_get_first_byte_inline(0x9F8101) );
+    }
+
+    {
+        assert( 0xA6     == BERTLV_TAG_MAKE(2, 1, 6) );
+        assert( 0x5E     == BERTLV_TAG_MAKE(1, 0, 30) );
+        assert( 0x5F1F   == BERTLV_TAG_MAKE(1, 0, 31) );
+        assert( 0xBF8619 == BERTLV_TAG_MAKE(2, 1, 793) );
+        for(long num = 0; num < 0x200000; num += 7)
+            assert( bertlv_tag_make(3, 1, num) == BERTLV_TAG_MAKE(3, 1, num) );
+
+        assert( 2 == BERTLV_TAG_SIZE(0x9F02) );
+        assert( 3 == BERTLV_LEN_SIZE(500) );
+        assert( 2+3+500 == BERTLV_TOTAL_SIZE(0xDF07, 500) );
+    }
 }
 //------------------------------------------------------------------------------
 void test_tlv_elements(void)
@@ -219,6 +272,23 @@ void test_tlv_elements(void)
         assert( sizeof(data) == bertlv_get_length(tlv) );
         assert( 0 == memcmp(bertlv_get_value(tlv), data, sizeof(data)) );
     }
+
+    {
+        static const uint8_t tlv[2+3+500] = { 0xBF,0x0C, 0x82,0x01,0xF4 };
+
+        bertlv_header_t header;
+        assert( sizeof(tlv) == bertlv_decode_header(tlv, &header) );
+        assert( 0xBF0C == header.tag );
+        assert( 2 == header.tag_size );
+        assert( 500 == header.length );
+        assert( 3 == header.len_size );
+        assert( tlv + 5 == header.value );
+        assert( sizeof(tlv) == header.total_size );
+
+        static const uint8_t bad[] = { 0x00, 0x00 };
+        assert( 0 == bertlv_decode_header(bad, &header) );
+        assert( 0 == bertlv_decode_header(NULL, &header) );
+    }
 }
 //------------------------------------------------------------------------------
 void test_tlv_group(void)
@@ -269,6 +339,24 @@ void test_tlv_group(void)
         assert( !tlv );
     }
 
+    {
+        bertlv_iter_t iter;
+        bertlv_iter_init(&iter, group, sizeof(group));
+
+        bertlv_header_t header;
+        const uint8_t *tlv;
+
+        tlv = bertlv_iter_get_next_header(&iter, &header);
+        assert( tlv == group );
+        assert( 0xC1 == header.tag );
+        assert( 2 == header.length );
+        assert( tlv + 2 == header.value );
+
+        tlv = bertlv_iter_get_next_header(&iter, &header);
+        assert( tlv == group + 4 );
+        assert( 0xC2 == header.tag );
+    }
+
     {
         assert( 5 == bertlv_grp_count(group, sizeof(group)) );
 
@@ -282,14 +370,1698 @@ void test_tlv_group(void)
         assert( !tlv );
     }
 
+    {
+        static const bertlv_tag_t tags[] = { 0xC5, 0xC7, 0xC1, 0xC5 };
+        const void *found[4];
+
+        assert( 3 == bertlv_grp_find_many(group, sizeof(group), tags, 4, found) );
+        assert( found[0] == group + 16 );
+        assert( found[1] == NULL );
+        assert( found[2] == group );
+        assert( found[3] == group + 16 );
+
+        assert( 2 == bertlv_grp_find_many(group, sizeof(group), tags + 2, 2, found) );
+        assert( found[0] == group );
+        assert( found[1] == group + 16 );
+
+        assert( 0 == bertlv_grp_find_many(group, sizeof(group), tags, 0, found) );
+    }
+
     assert( 20 == bertlv_grp_calc_total_size(group, sizeof(group)) );
 }
 //------------------------------------------------------------------------------
+void test_bounds_checking(void)
+{
+    bertlv_header_t header;
+
+    {
+        static const uint8_t tlv[] = { 0x9F,0x37, 0x03, 0x01,0x35,0x79 };
+
+        assert( BERTLV_OK == bertlv_decode_header_s(tlv, sizeof(tlv), &header) );
+        assert( 0x9F37 == header.tag );
+        assert( 3 == header.length );
+        assert( sizeof(tlv) == header.total_size );
+
+        assert( 0x9F37 == bertlv_get_tag_s(tlv, sizeof(tlv)) );
+        assert( 3 == bertlv_get_length_s(tlv, sizeof(tlv)) );
+        assert( tlv + 3 == bertlv_get_value_s(tlv, sizeof(tlv)) );
+        assert( sizeof(tlv) == bertlv_get_total_size_s(tlv, sizeof(tlv)) );
+
+        assert( BERTLV_ERR_TRUNCATED == bertlv_decode_header_s(tlv, 0, &header) );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_decode_header_s(tlv, 1, &header) );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_decode_header_s(tlv, 2, &header) );
+        assert( BERTLV_ERR_OVERRUN   == bertlv_decode_header_s(tlv, 5, &header) );
+        assert( 0 == bertlv_get_tag_s(tlv, 5) );
+        assert( !bertlv_get_value_s(tlv, 5) );
+    }
+
+    {
+        static const uint8_t tlv[] = { 0x00, 0x00 };
+        assert( BERTLV_ERR_NULL_TAG == bertlv_decode_header_s(tlv, sizeof(tlv), &header) );
+    }
+
+    {
+        static const uint8_t tlv[] = { 0x5F,0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x81,0x01, 0x00 };
+        assert( BERTLV_ERR_TAG_TOO_LONG == bertlv_decode_header_s(tlv, sizeof(tlv), &header) );
+    }
+
+    {
+        static const uint8_t tlv[] = { 0xC1, 0x80 };
+        assert( BERTLV_ERR_BAD_LENGTH == bertlv_decode_header_s(tlv, sizeof(tlv), &header) );
+    }
+
+    {
+        static const uint8_t tlv[] = { 0xC1, 0x89, 0,0,0,0,0,0,0,0,1 };
+        assert( BERTLV_ERR_LENGTH_TOO_LONG == bertlv_decode_header_s(tlv, sizeof(tlv), &header) );
+    }
+
+    {
+        static const uint8_t group[] =
+        {
+            0xC1, 0x02, 0x11,0x11,
+            0xC2, 0x82, 0x01        // Truncated length field
+        };
+
+        bertlv_iter_t iter;
+        bertlv_iter_init(&iter, group, sizeof(group));
+        assert( bertlv_iter_get_next(&iter) == group );
+        assert( BERTLV_OK == bertlv_iter_get_error(&iter) );
+        assert( !bertlv_iter_get_next(&iter) );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_iter_get_error(&iter) );
+        assert( !bertlv_iter_get_next(&iter) );
+
+        bertlv_iter_init(&iter, group, 4);
+        assert( bertlv_iter_get_next(&iter) == group );
+        assert( !bertlv_iter_get_next(&iter) );
+        assert( BERTLV_OK == bertlv_iter_get_error(&iter) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_index(void)
+{
+    static const uint8_t group[] =
+    {
+        0x9F,0x02, 0x01, 0x11,  // TLV 1
+        0x5F,0x2A, 0x01, 0x22,  // TLV 2
+        0x9F,0x1A, 0x01, 0x33,  // TLV 3
+        0x5F,0x2A, 0x01, 0x44,  // TLV 4 (duplicated tag)
+        0x9A,      0x01, 0x55,  // TLV 5
+        0x5F,0x2A, 0x01, 0x66,  // TLV 6 (duplicated tag)
+    };
+
+    bertlv_index_t       index;
+    bertlv_index_entry_t entries[8];
+
+    assert( 6 == bertlv_index_build(&index, NULL, 0, group, sizeof(group)) );
+
+    assert( 0 == bertlv_index_build(&index, entries, 5, group, sizeof(group)) );
+    assert( 6 == bertlv_index_build(&index, entries, 8, group, sizeof(group)) );
+
+    assert( bertlv_index_find(&index, 0x9F02) == group + 0 );
+    assert( bertlv_index_find(&index, 0x9F1A) == group + 8 );
+    assert( bertlv_index_find(&index, 0x9A  ) == group + 16 );
+    assert( bertlv_index_find(&index, 0x5F2A) == group + 4 );
+    assert( !bertlv_index_find(&index, 0x9F03) );
+    assert( !bertlv_index_find(&index, 0xFFFF) );
+
+    const bertlv_index_entry_t *first;
+    assert( 3 == bertlv_index_find_all(&index, 0x5F2A, &first) );
+    assert( first[0].tlv == group + 4 );
+    assert( first[1].tlv == group + 12 );
+    assert( first[2].tlv == group + 19 );
+
+    assert( 0 == bertlv_index_find_all(&index, 0x9F03, &first) );
+    assert( !first );
+}
+//------------------------------------------------------------------------------
+static const uint8_t nested_msg[] =
+{
+    0x6F, 0x0E,                             // 6F
+        0x84, 0x02, 0xA0,0x00,              //   84
+        0xA5, 0x08,                         //   A5
+            0x50, 0x01, 0x41,               //     50
+            0xBF,0x0C, 0x00,                //     BF0C
+            0x87, 0x00,                     //     87
+    0x70, 0x0A,                             // 70
+        0x77, 0x04,                         //   77
+            0x9F,0x26, 0x01, 0x26,          //     9F26
+        0x5A, 0x02, 0x12,0x34,              //   5A
+};
+
+static int count_walk(void *arg, const void *tlv, const bertlv_header_t *header, unsigned depth)
+{
+    unsigned *counts = arg;
+    ++counts[depth];
+    return header->tag == 0xA5 ? BERTLV_WALK_SKIP : BERTLV_WALK_CONTINUE;
+}
+
+void test_tlv_tree(void)
+{
+    {
+        static const bertlv_tag_t    tags  [] = { 0x6F, 0x84, 0xA5, 0x50, 0xBF0C, 0x87, 0x70, 0x77, 0x9F26, 0x5A };
+        static const unsigned        depths[] = { 0,    1,    1,    2,    2,      2,    0,    1,    2,      1    };
+
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init(&iter, nested_msg, sizeof(nested_msg));
+
+        bertlv_header_t header;
+        for(size_t i=0; i<sizeof(tags)/sizeof(tags[0]); ++i)
+        {
+            assert( bertlv_tree_iter_get_next(&iter, &header) );
+            assert( tags[i] == header.tag );
+            assert( depths[i] == bertlv_tree_iter_get_depth(&iter) );
+        }
+
+        assert( !bertlv_tree_iter_get_next(&iter, &header) );
+        assert( BERTLV_OK == bertlv_tree_iter_get_error(&iter) );
+    }
+
+    {
+        unsigned counts[BERTLV_TREE_DEPTH_MAX] = {0};
+        assert( BERTLV_OK == bertlv_walk(nested_msg, sizeof(nested_msg), count_walk, counts) );
+        assert( 2 == counts[0] );
+        assert( 4 == counts[1] );
+        assert( 1 == counts[2] );
+    }
+
+    {
+        const uint8_t *tlv = bertlv_find_path(nested_msg,
+                                              sizeof(nested_msg),
+                                              (bertlv_tag_t[]){ 0x70, 0x77, 0x9F26 },
+                                              3);
+        assert( tlv == nested_msg + 20 );
+        assert( !bertlv_find_path(nested_msg, sizeof(nested_msg), (bertlv_tag_t[]){ 0x70, 0x9F26 }, 2) );
+    }
+
+    {
+        static const bertlv_tag_t path1[] = { 0x6F, 0xA5, 0xBF0C };
+        static const bertlv_tag_t path2[] = { 0x70, 0x5A };
+        static const bertlv_tag_t path3[] = { 0x6F, 0x9F26 };
+        static const bertlv_tag_t path4[] = { 0x6F };
+        const bertlv_path_t paths[] =
+        {
+            { path1, 3 },
+            { path2, 2 },
+            { path3, 2 },
+            { path4, 1 },
+        };
+
+        const void *results[4];
+        assert( 3 == bertlv_find_paths(nested_msg, sizeof(nested_msg), paths, 4, results) );
+        assert( results[0] == nested_msg + 11 );
+        assert( results[1] == nested_msg + 24 );
+        assert( results[2] == NULL );
+        assert( results[3] == nested_msg );
+    }
+
+    {
+        uint8_t deep[2*BERTLV_TREE_DEPTH_MAX];
+        for(size_t i=0; i<BERTLV_TREE_DEPTH_MAX; ++i)
+        {
+            deep[2*i]   = 0x30;
+            deep[2*i+1] = sizeof(deep) - 2*( i + 1 );
+        }
+
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init(&iter, deep, sizeof(deep));
+
+        bertlv_header_t header;
+        while( bertlv_tree_iter_get_next(&iter, &header) )
+        {}
+        assert( BERTLV_ERR_TOO_DEEP == bertlv_tree_iter_get_error(&iter) );
+    }
+
+    {
+        // Lazy mode descends into the entered elements only.
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init_lazy(&iter, nested_msg, sizeof(nested_msg));
+
+        bertlv_header_t header;
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x6F );
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x70 );
+        assert( bertlv_tree_iter_enter(&iter) );
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x77 );
+        assert( 1 == bertlv_tree_iter_get_depth(&iter) );
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x5A );
+        assert( !bertlv_tree_iter_enter(&iter) );
+        assert( !bertlv_tree_iter_get_next(&iter, &header) );
+        assert( BERTLV_OK == bertlv_tree_iter_get_error(&iter) );
+    }
+
+    {
+        // Leave the rest of a level.
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init_lazy(&iter, nested_msg, sizeof(nested_msg));
+
+        bertlv_header_t header;
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x6F );
+        assert( bertlv_tree_iter_enter(&iter) );
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x84 );
+        bertlv_tree_iter_leave(&iter);
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x70 );
+        assert( 0 == bertlv_tree_iter_get_depth(&iter) );
+        bertlv_tree_iter_leave(&iter);
+        assert( !bertlv_tree_iter_get_next(&iter, &header) );
+    }
+
+    {
+        // Children of the elements not entered are never decoded.
+        static const uint8_t msg[] =
+        {
+            0x70, 0x03, 0x9F, 0x26, 0x05,   // Malformed child
+            0x5A, 0x01, 0x12,
+        };
+
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init_lazy(&iter, msg, sizeof(msg));
+
+        bertlv_header_t header;
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x70 );
+        assert( bertlv_tree_iter_get_next(&iter, &header) && header.tag == 0x5A );
+        assert( !bertlv_tree_iter_get_next(&iter, &header) );
+        assert( BERTLV_OK == bertlv_tree_iter_get_error(&iter) );
+
+        bertlv_tree_iter_init_lazy(&iter, msg, sizeof(msg));
+        assert( bertlv_tree_iter_get_next(&iter, &header) );
+        assert( bertlv_tree_iter_enter(&iter) );
+        assert( !bertlv_tree_iter_get_next(&iter, &header) );
+        assert( BERTLV_ERR_OVERRUN == bertlv_tree_iter_get_error(&iter) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_builder(void)
+{
+    {
+        uint8_t buf[64];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        assert( bertlv_builder_begin(&builder, 0x6F, 0) );
+        assert( bertlv_builder_append(&builder, 0x84, (uint8_t[]){ 0xA0,0x00 }, 2) );
+        assert( bertlv_builder_begin(&builder, 0xA5, 0) );
+        assert( bertlv_builder_append(&builder, 0x50, (uint8_t[]){ 0x41 }, 1) );
+        assert( bertlv_builder_begin(&builder, 0xBF0C, 0) );
+        assert( bertlv_builder_end(&builder) );
+        assert( bertlv_builder_alloc(&builder, 0x87, 0) );
+        assert( 0 == bertlv_builder_finish(&builder) );
+        assert( bertlv_builder_end(&builder) );
+        assert( bertlv_builder_end(&builder) );
+        assert( !bertlv_builder_end(&builder) );
+        assert( 0 == bertlv_builder_finish(&builder) );
+    }
+
+    {
+        uint8_t buf[64];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        assert( bertlv_builder_begin(&builder, 0x6F, 0) );
+        assert( bertlv_builder_append(&builder, 0x84, (uint8_t[]){ 0xA0,0x00 }, 2) );
+        assert( bertlv_builder_begin(&builder, 0xA5, 0) );
+        assert( bertlv_builder_append(&builder, 0x50, (uint8_t[]){ 0x41 }, 1) );
+        assert( bertlv_builder_begin(&builder, 0xBF0C, 0) );
+        assert( bertlv_builder_end(&builder) );
+        assert( bertlv_builder_alloc(&builder, 0x87, 0) );
+        assert( bertlv_builder_end(&builder) );
+        assert( bertlv_builder_end(&builder) );
+
+        assert( 16 == bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, nested_msg, 16) );
+    }
+
+    {
+        // The length field grows past the reserved size.
+        static const uint8_t data[200] = {0};
+
+        uint8_t buf[256];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        assert( bertlv_builder_begin(&builder, 0x70, 0) );
+        uint8_t *value = bertlv_builder_alloc(&builder, 0x9F46, sizeof(data));
+        assert( value == buf + 2 + 4 );
+        memcpy(value, data, sizeof(data));
+        assert( bertlv_builder_end(&builder) );
+
+        assert( 3 + 4+200 == bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, (uint8_t[]){ 0x70, 0x81,0xCC, 0x9F,0x46, 0x81,0xC8 }, 7) );
+    }
+
+    {
+        // Reserved length field larger than needed.
+        uint8_t buf[64];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        assert( bertlv_builder_begin(&builder, 0x77, 1000) );
+        assert( bertlv_builder_append(&builder, 0x9F36, (uint8_t[]){ 0x00,0x01 }, 2) );
+        assert( bertlv_builder_end(&builder) );
+
+        static const uint8_t expected[] = { 0x77, 0x82,0x00,0x05, 0x9F,0x36, 0x02, 0x00,0x01 };
+        assert( sizeof(expected) == bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, expected, sizeof(expected)) );
+        assert( 5 == bertlv_get_length(buf) );
+    }
+
+    {
+        // Buffer overflow.
+        uint8_t buf[8];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        assert( bertlv_builder_begin(&builder, 0x77, 0) );
+        assert( !bertlv_builder_append(&builder, 0x9F36, (uint8_t[]){ 0,1,2,3 }, 4) );
+        assert( !bertlv_builder_end(&builder) );
+        assert( 0 == bertlv_builder_finish(&builder) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_rwriter(void)
+{
+    {
+        uint8_t buf[64];
+        bertlv_rwriter_t writer;
+        bertlv_rwriter_init(&writer, buf, sizeof(buf));
+
+        assert( bertlv_rwriter_open(&writer) );
+            assert( bertlv_rwriter_put(&writer, 0x5A, (uint8_t[]){ 0x12,0x34 }, 2) );
+            assert( bertlv_rwriter_open(&writer) );
+                assert( bertlv_rwriter_put(&writer, 0x9F26, (uint8_t[]){ 0x26 }, 1) );
+            assert( bertlv_rwriter_close(&writer, 0x77) );
+        assert( bertlv_rwriter_close(&writer, 0x70) );
+
+        assert( bertlv_rwriter_open(&writer) );
+            assert( bertlv_rwriter_open(&writer) );
+                assert( bertlv_rwriter_alloc(&writer, 0x87, 0) );
+                assert( bertlv_rwriter_open(&writer) );
+                assert( bertlv_rwriter_close(&writer, 0xBF0C) );
+                assert( bertlv_rwriter_put(&writer, 0x50, (uint8_t[]){ 0x41 }, 1) );
+            assert( bertlv_rwriter_close(&writer, 0xA5) );
+            assert( bertlv_rwriter_put(&writer, 0x84, (uint8_t[]){ 0xA0,0x00 }, 2) );
+
+        size_t size;
+        assert( !bertlv_rwriter_finish(&writer, &size) );
+        assert( bertlv_rwriter_close(&writer, 0x6F) );
+
+        const uint8_t *data = bertlv_rwriter_finish(&writer, &size);
+        assert( data == buf + sizeof(buf) - sizeof(nested_msg) );
+        assert( size == sizeof(nested_msg) );
+        assert( 0 == memcmp(data, nested_msg, sizeof(nested_msg)) );
+    }
+
+    {
+        static const uint8_t data[500] = {0};
+
+        uint8_t buf1[1024], buf2[1024];
+        bertlv_rwriter_t writer;
+        bertlv_rwriter_init(&writer, buf1, sizeof(buf1));
+        assert( bertlv_rwriter_put(&writer, 0xDF07, data, sizeof(data)) );
+
+        size_t size;
+        const void *tlv = bertlv_rwriter_finish(&writer, &size);
+        assert( size == bertlv_encode(buf2, sizeof(buf2), 0xDF07, data, sizeof(data)) );
+        assert( 0 == memcmp(tlv, buf2, size) );
+    }
+
+    {
+        uint8_t buf[4];
+        bertlv_rwriter_t writer;
+        bertlv_rwriter_init(&writer, buf, sizeof(buf));
+        assert( !bertlv_rwriter_put(&writer, 0x9F36, (uint8_t[]){ 0x00,0x01 }, 2) );
+
+        size_t size;
+        assert( !bertlv_rwriter_finish(&writer, &size) );
+        assert( 0 == size );
+    }
+}
+//------------------------------------------------------------------------------
+typedef struct stream_log_t
+{
+    int          types [64];
+    bertlv_tag_t tags  [64];
+    unsigned     depths[64];
+    size_t       count;
+    uint8_t      values[64];
+    size_t       value_size;
+} stream_log_t;
+
+static bool stream_log_event(void *arg, const bertlv_event_t *event)
+{
+    stream_log_t *log = arg;
+
+    if( event->type == BERTLV_EVENT_VALUE )
+    {
+        memcpy(log->values + log->value_size, event->data, event->size);
+        log->value_size += event->size;
+    }
+
+    if( event->type == BERTLV_EVENT_VALUE &&
+        log->count && log->types[log->count-1] == BERTLV_EVENT_VALUE )
+    {
+        return true;
+    }
+
+    log->types [log->count] = event->type;
+    log->tags  [log->count] = event->tag;
+    log->depths[log->count] = event->depth;
+    ++log->count;
+
+    return true;
+}
+
+void test_tlv_stream(void)
+{
+    static const int T = BERTLV_EVENT_TAG;
+    static const int L = BERTLV_EVENT_LENGTH;
+    static const int V = BERTLV_EVENT_VALUE;
+    static const int E = BERTLV_EVENT_END;
+
+    static const int          types[] = { T,L,   T,L,V,   T,L,   T,L,V,   T,L,E,     T,L,   E,    E,
+                                          T,L,   T,L,   T,L,V,   E,     T,L,V,   E    };
+    static const bertlv_tag_t tags [] = { 0x6F,0x6F, 0x84,0x84,0x84, 0xA5,0xA5, 0x50,0x50,0x50,
+                                          0xBF0C,0xBF0C,0xBF0C, 0x87,0x87, 0xA5, 0x6F,
+                                          0x70,0x70, 0x77,0x77, 0x9F26,0x9F26,0x9F26, 0x77,
+                                          0x5A,0x5A,0x5A, 0x70 };
+    static const unsigned     depths[] = { 0,0, 1,1,1, 1,1, 2,2,2, 2,2,2, 2,2, 1, 0,
+                                           0,0, 1,1, 2,2,2, 1, 1,1,1, 0 };
+    static const size_t       nevents = sizeof(types)/sizeof(types[0]);
+
+    static const uint8_t values[] = { 0xA0,0x00, 0x41, 0x26, 0x12,0x34 };
+
+    for(size_t chunk = 1; chunk <= sizeof(nested_msg); ++chunk)
+    {
+        stream_log_t log = {0};
+
+        bertlv_stream_t stream;
+        bertlv_stream_init(&stream, stream_log_event, &log);
+
+        for(size_t pos = 0; pos < sizeof(nested_msg); pos += chunk)
+        {
+            size_t size = ( sizeof(nested_msg) - pos < chunk )?( sizeof(nested_msg) - pos ):( chunk );
+            assert( BERTLV_OK == bertlv_stream_feed(&stream, nested_msg + pos, size) );
+
+            if( pos + size < sizeof(nested_msg) && pos + size != 16 )
+                assert( BERTLV_ERR_TRUNCATED == bertlv_stream_finish(&stream) );
+        }
+
+        assert( BERTLV_OK == bertlv_stream_finish(&stream) );
+        assert( sizeof(nested_msg) == bertlv_stream_get_offset(&stream) );
+
+        assert( nevents == log.count );
+        assert( 0 == memcmp(log.types,  types,  sizeof(types)) );
+        assert( 0 == memcmp(log.tags,   tags,   sizeof(tags)) );
+        assert( 0 == memcmp(log.depths, depths, sizeof(depths)) );
+        assert( sizeof(values) == log.value_size );
+        assert( 0 == memcmp(log.values, values, sizeof(values)) );
+    }
+
+    {
+        // Child element runs past the end of its parent.
+        static const uint8_t data[] = { 0x70, 0x03, 0x5A, 0x02, 0x12,0x34 };
+
+        stream_log_t log = {0};
+        bertlv_stream_t stream;
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_ERR_OVERRUN == bertlv_stream_feed(&stream, data, sizeof(data)) );
+        assert( BERTLV_ERR_OVERRUN == bertlv_stream_finish(&stream) );
+    }
+
+    {
+        static const uint8_t data[] = { 0xC1, 0x89 };
+
+        stream_log_t log = {0};
+        bertlv_stream_t stream;
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_ERR_LENGTH_TOO_LONG == bertlv_stream_feed(&stream, data, sizeof(data)) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_file(void)
+{
+    static const uint8_t records[] =
+    {
+        0xC1, 0x02, 0x11,0x11,      // Record 1
+        0xC2, 0x02, 0x22,0x22,      // Record 2
+        0xDF, 0x85,                 // Corrupt record
+        0xC3, 0x02, 0x33,0x33,      // Record 3
+        0xC4, 0x02, 0x44,0x44,      // Record 4
+        0x00, 0x00,                 // Trailing padding
+    };
+
+    char filename[] = "/tmp/bertlv_test_XXXXXX";
+    int fd = mkstemp(filename);
+    assert( fd >= 0 );
+    assert( sizeof(records) == write(fd, records, sizeof(records)) );
+    close(fd);
+
+    bertlv_file_t file;
+    assert( bertlv_file_open(&file, filename) );
+
+    {
+        bertlv_iter_t iter;
+        bertlv_file_init_iter(&file, &iter);
+        assert( bertlv_iter_get_next(&iter) );
+        assert( bertlv_iter_get_next(&iter) );
+        assert( !bertlv_iter_get_next(&iter) );
+        assert( BERTLV_ERR_OVERRUN == bertlv_iter_get_error(&iter) );
+    }
+
+    {
+        bertlv_header_t header;
+        const uint8_t *tlv;
+
+        static const bertlv_tag_t tags[] = { 0xC1, 0xC2, 0xC3, 0xC4 };
+        for(size_t i=0; i<4; ++i)
+        {
+            tlv = bertlv_file_get_next(&file, &header);
+            assert( tlv );
+            assert( tags[i] == header.tag );
+            assert( 0 == memcmp(tlv, records + 4*i + ( i >= 2 ? 2 : 0 ), 4) );
+        }
+
+        assert( !bertlv_file_get_next(&file, &header) );
+        assert( 2 == bertlv_file_get_resyncs(&file) );
+        assert( 4 == bertlv_file_get_skipped(&file) );
+
+        bertlv_file_rewind(&file);
+        assert( bertlv_file_get_next(&file, &header) == file.data );
+    }
+
+    bertlv_file_close(&file);
+    remove(filename);
+
+    assert( !bertlv_file_open(&file, filename) );
+
+    {
+        // Garbage that looks like indefinite length elements be skipped without searching their ends.
+        static uint8_t garbage[1998 + 8];
+        for(size_t i=0; i<1998; i+=3)
+            memcpy(garbage + i, (uint8_t[]){ 0x30, 0x80, 0xFF }, 3);
+        memcpy(garbage + 1998, records, 8);
+
+        char garbage_name[] = "/tmp/bertlv_test_XXXXXX";
+        fd = mkstemp(garbage_name);
+        assert( fd >= 0 );
+        assert( sizeof(garbage) == write(fd, garbage, sizeof(garbage)) );
+        close(fd);
+
+        assert( bertlv_file_open(&file, garbage_name) );
+
+        bertlv_header_t header;
+        assert( bertlv_file_get_next(&file, &header) == file.data + 1998 && 0xC1 == header.tag );
+        assert( bertlv_file_get_next(&file, &header) == file.data + 2002 && 0xC2 == header.tag );
+        assert( !bertlv_file_get_next(&file, &header) );
+        assert( 1 == bertlv_file_get_resyncs(&file) );
+        assert( 1998 == bertlv_file_get_skipped(&file) );
+
+        bertlv_file_close(&file);
+        remove(garbage_name);
+    }
+}
+//------------------------------------------------------------------------------
+static void par_mark(void *arg, const void *tlv, const bertlv_header_t *header, size_t index)
+{
+    uint8_t *marks = arg;
+    marks[index] = *(const uint8_t*)header->value;
+}
+
+static void par_save(void *arg, const void *tlv, const bertlv_header_t *header, size_t index)
+{
+    bertlv_header_t *headers = arg;
+    headers[index] = *header;
+}
+
+void test_tlv_par(void)
+{
+    enum { count = 1000 };
+
+    static uint8_t group[3*count + 2];
+    for(size_t i=0; i<count; ++i)
+    {
+        group[3*i+0] = ( i % 7 )?( 0xC1 ):( 0xC7 );
+        group[3*i+1] = 0x01;
+        group[3*i+2] = i & 0xFF;
+    }
+
+    static const unsigned threads[] = { 0, 1, 3, 8, 2000 };
+    for(size_t t=0; t<sizeof(threads)/sizeof(threads[0]); ++t)
+    {
+        static uint8_t marks[count];
+        memset(marks, 0, sizeof(marks));
+
+        assert( count == bertlv_par_scan(group, sizeof(group), threads[t], par_mark, marks) );
+        for(size_t i=0; i<count; ++i)
+            assert( marks[i] == ( i & 0xFF ) );
+
+        assert( 143 == bertlv_par_count(group, sizeof(group), threads[t], 0xC7) );
+        assert( 857 == bertlv_par_count(group, sizeof(group), threads[t], 0xC1) );
+        assert( 0 == bertlv_par_count(group, sizeof(group), threads[t], 0xC2) );
+
+        assert( bertlv_par_find(group, sizeof(group), threads[t], 0xC7) == group );
+        assert( bertlv_par_find(group, sizeof(group), threads[t], 0xC1) == group + 3 );
+        assert( !bertlv_par_find(group, sizeof(group), threads[t], 0xC2) );
+    }
+
+    assert( 0 == bertlv_par_scan(group, 0, 4, par_mark, NULL) );
+
+    {
+        // The payload of a large element looks like elements,
+        // and the boundaries guessed in it must be corrected.
+        static uint8_t tricky[300 + 4 + 2000 + 300 + 3];
+        uint8_t *pos = tricky;
+        for(size_t i=0; i<100; ++i, pos += 3)
+            memcpy(pos, (uint8_t[]){ 0xC1, 0x01, 0x00 }, 3);
+        memcpy(pos, (uint8_t[]){ 0xC3, 0x82, 0x07, 0xD0 }, 4);
+        pos += 4;
+        for(size_t i=0; i<2000; ++i)
+            *pos++ = ( i % 3 == 0 )?( 0xC7 ):( i % 3 == 1 )?( 0x01 ):( i & 0xFF );
+        for(size_t i=0; i<100; ++i, pos += 3)
+            memcpy(pos, (uint8_t[]){ 0xC1, 0x01, 0x00 }, 3);
+        memcpy(pos, (uint8_t[]){ 0xC7, 0x01, 0xFF }, 3);
+
+        for(size_t t=0; t<sizeof(threads)/sizeof(threads[0]); ++t)
+        {
+            static uint8_t marks[202];
+            assert( 202 == bertlv_par_scan(tricky, sizeof(tricky), threads[t], par_mark, marks) );
+            assert( 0xFF == marks[201] );
+
+            assert( 1 == bertlv_par_count(tricky, sizeof(tricky), threads[t], 0xC7) );
+            assert( 200 == bertlv_par_count(tricky, sizeof(tricky), threads[t], 0xC1) );
+            assert( bertlv_par_find(tricky, sizeof(tricky), threads[t], 0xC7) == tricky + sizeof(tricky) - 3 );
+            assert( bertlv_par_find(tricky, sizeof(tricky), threads[t], 0xC3) == tricky + 300 );
+        }
+    }
+
+    {
+        // An element with indefinite length must be walked over as a whole.
+        static const uint8_t mixed[] =
+        {
+            0xC7, 0x00,
+            0xA1, 0x80, 0xC1, 0x01, 0x55, 0x00, 0x00,
+            0xC2, 0x00,
+        };
+
+        for(size_t t=0; t<sizeof(threads)/sizeof(threads[0]); ++t)
+        {
+            bertlv_header_t headers[3];
+            assert( 3 == bertlv_par_scan(mixed, sizeof(mixed), threads[t], par_save, headers) );
+            assert( 0xA1 == headers[1].tag );
+            assert( 7 == headers[1].total_size && headers[1].indefinite );
+            assert( 0xC2 == headers[2].tag );
+
+            assert( bertlv_par_find(mixed, sizeof(mixed), threads[t], 0xC2) == mixed + 9 );
+            assert( !bertlv_par_find(mixed, sizeof(mixed), threads[t], 0xC1) );
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_scan(void)
+{
+    static uint8_t group[4096];
+    srand(1);
+
+    for(int round=0; round<200; ++round)
+    {
+        // Random elements with short and long headers, and may end with garbage.
+        size_t size;
+        while( size < sizeof(group) - 300 )
+        {
+            int shape = rand() % 8;
+            bertlv_tag_t tag = ( shape < 4 )?( 0xC1 + shape ):
+                               ( shape < 6 )?( 0x9F00 | ( rand() & 0x7F ) ):( 0xDF8101 );
+            size_t length = ( shape == 7 )?( rand() % 300 ):( rand() % 6 );
+
+            uint8_t data[300];
+            memset(data, 0x9F, length);
+            size += bertlv_encode(group + size, sizeof(group) - size, tag, data, length);
+        }
+
+        if( round % 3 == 1 ) group[size++] = 0x9F;
+        if( round % 3 == 2 ) group[rand() % size] = 0x00;
+
+        size_t expected[4096];
+        size_t count = 0;
+
+        bertlv_iter_t iter;
+        bertlv_iter_init(&iter, group, size);
+        for(const uint8_t *tlv; ( tlv = bertlv_iter_get_next(&iter) ); )
+            expected[count++] = tlv - group;
+
+        size_t offsets[4096];
+        assert( count == bertlv_grp_scan(group, size, NULL, 0) );
+        assert( count == bertlv_grp_scan(group, size, offsets, 4096) );
+        assert( 0 == memcmp(offsets, expected, count*sizeof(size_t)) );
+
+        if( count > 3 )
+        {
+            offsets[3] = 0;
+            assert( count == bertlv_grp_scan(group, size, offsets, 3) );
+            assert( 0 == offsets[3] );
+        }
+    }
+
+    static const uint8_t padded[] = { 0xC1, 0x02, 0x11,0x11, 0x00, 0x00 };
+    assert( 1 == bertlv_grp_scan(padded, sizeof(padded), NULL, 0) );
+}
+//------------------------------------------------------------------------------
+typedef struct schema_obj_t
+{
+    bertlv_value_t aid;
+    bertlv_value_t label;
+    uint64_t       cid;
+    uint8_t        pan[4];
+    bertlv_value_t missing;
+} schema_obj_t;
+
+void test_tlv_schema(void)
+{
+    static const bertlv_schema_field_t fields[] =
+    {
+        { 0x84,   offsetof(schema_obj_t, aid),     BERTLV_FIELD_VALUE, 2, 16, true  },
+        { 0x50,   offsetof(schema_obj_t, label),   BERTLV_FIELD_VALUE, 1, 16, true  },
+        { 0x9F26, offsetof(schema_obj_t, cid),     BERTLV_FIELD_UINT,  1, 8,  true  },
+        { 0x5A,   offsetof(schema_obj_t, pan),     BERTLV_FIELD_BYTES, 1, 4,  true  },
+        { 0x9F36, offsetof(schema_obj_t, missing), BERTLV_FIELD_VALUE, 2, 2,  false },
+    };
+    static const size_t count = sizeof(fields)/sizeof(fields[0]);
+
+    bertlv_schema_t      schema;
+    bertlv_schema_slot_t slots[5];
+    assert( bertlv_schema_compile(&schema, fields, count, slots) );
+
+    {
+        schema_obj_t obj;
+        memset(&obj, 0xCC, sizeof(obj));
+
+        uint8_t status[5];
+        assert( BERTLV_OK == bertlv_decode_schema(&schema, nested_msg, sizeof(nested_msg), &obj, status) );
+        assert( obj.aid.data == nested_msg + 4 && obj.aid.size == 2 );
+        assert( obj.label.data == nested_msg + 10 && obj.label.size == 1 );
+        assert( obj.cid == 0x26 );
+        assert( 0 == memcmp(obj.pan, (uint8_t[]){ 0x12,0x34,0x00,0x00 }, 4) );
+        assert( !obj.missing.data && !obj.missing.size );
+        assert( 0 == memcmp(status, (uint8_t[]){ 1,1,1,1,0 }, 5) );
+    }
+
+    {
+        // Only the constructed element 70 be given, 84 and 50 are missing.
+        schema_obj_t obj;
+        assert( BERTLV_ERR_MISSING_FIELD == bertlv_decode_schema(&schema, nested_msg + 16, 12, &obj, NULL) );
+        assert( obj.cid == 0x26 );
+        assert( !obj.aid.data );
+    }
+
+    {
+        static const uint8_t group[] =
+        {
+            0x84, 0x01, 0xA0,               // Too short
+            0x50, 0x01, 0x41,
+            0x9F,0x26, 0x01, 0x26,
+            0x5A, 0x01, 0x12,
+        };
+
+        schema_obj_t obj;
+        uint8_t status[5];
+        assert( BERTLV_ERR_INVALID_FIELD == bertlv_decode_schema(&schema, group, sizeof(group), &obj, status) );
+        assert( 0 == memcmp(status, (uint8_t[]){ 2,1,1,1,0 }, 5) );
+        assert( !obj.aid.data );
+    }
+
+    {
+        static const bertlv_schema_field_t dup[] =
+        {
+            { 0x84, 0, BERTLV_FIELD_VALUE, 0, 16, false },
+            { 0x84, 0, BERTLV_FIELD_VALUE, 0, 16, false },
+        };
+        assert( !bertlv_schema_compile(&schema, dup, 2, slots) );
+
+        static const bertlv_schema_field_t types[] =
+        {
+            { 0xA5, 0, BERTLV_FIELD_VALUE, 0, 16, false },
+            { 0x77, 0, BERTLV_FIELD_UINT,  0, 8,  false },
+        };
+        assert(  bertlv_schema_compile(&schema, types, 1, slots) );
+        assert( !bertlv_schema_compile(&schema, types, 2, slots) );
+
+        assert( !bertlv_schema_compile(&schema, types, BERTLV_SCHEMA_FIELDS_MAX + 1, slots) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_plan(void)
+{
+    static const bertlv_schema_field_t fields[] =
+    {
+        { 0x84,   offsetof(schema_obj_t, aid),     BERTLV_FIELD_VALUE, 2, 16, true  },
+        { 0x50,   offsetof(schema_obj_t, label),   BERTLV_FIELD_VALUE, 1, 16, false },
+        { 0x9F26, offsetof(schema_obj_t, cid),     BERTLV_FIELD_UINT,  2, 2,  true  },
+        { 0x5A,   offsetof(schema_obj_t, pan),     BERTLV_FIELD_BYTES, 4, 4,  false },
+    };
+
+    bertlv_plan_t      plan;
+    bertlv_plan_item_t items[4];
+    assert( bertlv_plan_compile(&plan, fields, 4, items) );
+
+    schema_obj_t obj =
+    {
+        .aid   = { (uint8_t[]){ 0xA0,0x00 }, 2 },
+        .label = { "VISA", 4 },
+        .cid   = 0x1234,
+        .pan   = { 0x47,0x61,0x73,0x90 },
+    };
+
+    {
+        static const uint8_t expected[] =
+        {
+            0x84, 0x02, 0xA0,0x00,
+            0x50, 0x04, 'V','I','S','A',
+            0x9F,0x26, 0x02, 0x12,0x34,
+            0x5A, 0x04, 0x47,0x61,0x73,0x90,
+        };
+
+        uint8_t buf[64];
+        assert( sizeof(expected) == bertlv_encode_plan(&plan, &obj, ~(uint64_t)0, NULL, 0) );
+        assert( sizeof(expected) == bertlv_encode_plan(&plan, &obj, ~(uint64_t)0, buf, sizeof(buf)) );
+        assert( 0 == memcmp(buf, expected, sizeof(expected)) );
+        assert( 0 == bertlv_encode_plan(&plan, &obj, ~(uint64_t)0, buf, sizeof(expected) - 1) );
+    }
+
+    {
+        // Optional fields skipped by the presence mask.
+        static const uint8_t expected[] =
+        {
+            0x84, 0x02, 0xA0,0x00,
+            0x9F,0x26, 0x02, 0x12,0x34,
+            0x5A, 0x04, 0x47,0x61,0x73,0x90,
+        };
+
+        uint8_t buf[64];
+        assert( sizeof(expected) == bertlv_encode_plan(&plan, &obj, 1 << 3, buf, sizeof(buf)) );
+        assert( 0 == memcmp(buf, expected, sizeof(expected)) );
+    }
+
+    {
+        // Value size out of range.
+        obj.aid.size = 1;
+        uint8_t buf[64];
+        assert( 0 == bertlv_encode_plan(&plan, &obj, 0, buf, sizeof(buf)) );
+    }
+
+    {
+        static const bertlv_schema_field_t bad[] =
+        {
+            { 0x9F26, 0, BERTLV_FIELD_UINT, 9, 9, true },
+        };
+        assert( !bertlv_plan_compile(&plan, bad, 1, items) );
+    }
+}
+//------------------------------------------------------------------------------
+static size_t flatten_iov(uint8_t *buf, const struct iovec *iov, size_t count)
+{
+    size_t size = 0;
+    for(size_t i=0; i<count; ++i)
+    {
+        memcpy(buf + size, iov[i].iov_base, iov[i].iov_len);
+        size += iov[i].iov_len;
+    }
+
+    return size;
+}
+
+void test_tlv_iov(void)
+{
+    static const uint8_t aid[]   = { 0xA0,0x00 };
+    static const uint8_t label[] = { 0x41 };
+
+    {
+        uint8_t      hdrbuf[32];
+        struct iovec iov[16];
+
+        bertlv_iov_t enc;
+        bertlv_iov_init(&enc, hdrbuf, sizeof(hdrbuf), iov, 16);
+
+        assert( bertlv_iov_begin(&enc, 0x6F) );
+            assert( bertlv_iov_add(&enc, 0x84, aid, sizeof(aid)) );
+            assert( bertlv_iov_begin(&enc, 0xA5) );
+                assert( bertlv_iov_add(&enc, 0x50, label, sizeof(label)) );
+                assert( bertlv_iov_begin(&enc, 0xBF0C) );
+                assert( bertlv_iov_end(&enc) );
+                assert( bertlv_iov_add(&enc, 0x87, NULL, 0) );
+            assert( bertlv_iov_end(&enc) );
+        assert( bertlv_iov_end(&enc) );
+        assert( bertlv_iov_add_raw(&enc, nested_msg + 16, 12) );
+
+        size_t count;
+        assert( sizeof(nested_msg) == bertlv_iov_finish(&enc, &count) );
+        assert( count == 8 );
+        assert( iov[1].iov_base == hdrbuf && iov[2].iov_base == aid );
+
+        uint8_t buf[64];
+        assert( sizeof(nested_msg) == flatten_iov(buf, iov, count) );
+        assert( 0 == memcmp(buf, nested_msg, sizeof(nested_msg)) );
+    }
+
+    {
+        // Payload spread across several buffers.
+        static const uint8_t part1[100] = {0};
+        static const uint8_t part2[100] = {0};
+        const struct iovec parts[] = { { (void*)part1, 100 }, { (void*)part2, 100 } };
+
+        uint8_t      hdrbuf[32];
+        struct iovec iov[8];
+
+        bertlv_iov_t enc;
+        bertlv_iov_init(&enc, hdrbuf, sizeof(hdrbuf), iov, 8);
+        assert( bertlv_iov_begin(&enc, 0x70) );
+        assert( bertlv_iov_add_vec(&enc, 0x9F46, parts, 2) );
+        assert( bertlv_iov_end(&enc) );
+
+        size_t count;
+        assert( 3 + 4 + 200 == bertlv_iov_finish(&enc, &count) );
+        assert( 4 == count );
+
+        uint8_t buf[256], expected[256];
+        assert( 3 + 4 + 200 == flatten_iov(buf, iov, count) );
+
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, expected, sizeof(expected));
+        bertlv_builder_begin(&builder, 0x70, 0);
+        static const uint8_t zeros[200] = {0};
+        bertlv_builder_append(&builder, 0x9F46, zeros, sizeof(zeros));
+        bertlv_builder_end(&builder);
+        assert( 3 + 4 + 200 == bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, expected, 3 + 4 + 200) );
+    }
+
+    {
+        uint8_t      hdrbuf[32];
+        struct iovec iov[2];
+
+        bertlv_iov_t enc;
+        bertlv_iov_init(&enc, hdrbuf, sizeof(hdrbuf), iov, 2);
+        assert( bertlv_iov_add(&enc, 0x84, aid, sizeof(aid)) );
+        assert( !bertlv_iov_add(&enc, 0x50, label, sizeof(label)) );
+
+        size_t count;
+        assert( 0 == bertlv_iov_finish(&enc, &count) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_dom(void)
+{
+    static const bertlv_tag_t tags   [] = { 0x6F, 0x84, 0xA5, 0x50, 0xBF0C, 0x87, 0x70, 0x77, 0x9F26, 0x5A };
+    static const uint32_t     parents[] = { BERTLV_NODE_NONE, 0, 0, 2, 2, 2, BERTLV_NODE_NONE, 6, 7, 6 };
+    static const uint32_t     nexts  [] = { 6, 2, BERTLV_NODE_NONE, 4, 5, BERTLV_NODE_NONE,
+                                            BERTLV_NODE_NONE, 9, BERTLV_NODE_NONE, BERTLV_NODE_NONE };
+
+    static uint64_t memory[128];
+
+    bertlv_arena_t arena;
+    bertlv_arena_init(&arena, memory, sizeof(memory));
+
+    {
+        bertlv_dom_t dom;
+        assert( BERTLV_OK == bertlv_dom_parse(&dom, &arena, nested_msg, sizeof(nested_msg)) );
+        assert( 10 == dom.count );
+        assert( (void*)dom.nodes == (void*)memory );
+        assert( 10 * sizeof(bertlv_node_t) == bertlv_arena_get_used(&arena) );
+
+        for(uint32_t i=0; i<dom.count; ++i)
+        {
+            const bertlv_node_t *node = bertlv_dom_get_node(&dom, i);
+            assert( tags[i] == node->tag );
+            assert( parents[i] == node->parent );
+            assert( nexts[i] == node->next );
+            assert( node->parent == BERTLV_NODE_NONE || dom.nodes[node->parent].depth + 1 == node->depth );
+        }
+
+        assert( 1 == dom.nodes[0].child );
+        assert( 3 == dom.nodes[2].child );
+        assert( BERTLV_NODE_NONE == dom.nodes[4].child );
+        assert( 8 == dom.nodes[7].child );
+
+        static const bertlv_tag_t path[] = { 0x70, 0x77, 0x9F26 };
+        const bertlv_node_t *node = bertlv_dom_find_path(&dom, path, 3);
+        assert( node && node->tlv == nested_msg + 20 && node->value == nested_msg + 23 && node->length == 1 );
+        assert( bertlv_dom_get_parent(&dom, node)->tag == 0x77 );
+        assert( !bertlv_dom_find_child(&dom, NULL, 0x77) );
+        assert( bertlv_dom_find_child(&dom, &dom.nodes[6], 0x5A) == &dom.nodes[9] );
+    }
+
+    {
+        // Nodes of the next message reuse the same memory.
+        bertlv_arena_reset(&arena);
+
+        bertlv_dom_t dom;
+        assert( BERTLV_OK == bertlv_dom_parse(&dom, &arena, nested_msg + 16, 12) );
+        assert( 4 == dom.count && (void*)dom.nodes == (void*)memory );
+    }
+
+    {
+        bertlv_arena_t small;
+        bertlv_arena_init(&small, memory, 3 * sizeof(bertlv_node_t));
+
+        bertlv_dom_t dom;
+        assert( BERTLV_ERR_NO_SPACE == bertlv_dom_parse(&dom, &small, nested_msg, sizeof(nested_msg)) );
+        assert( 0 == bertlv_arena_get_used(&small) && !dom.nodes );
+
+        assert( BERTLV_ERR_OVERRUN == bertlv_dom_parse(&dom, &arena, nested_msg, sizeof(nested_msg) - 1) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_view(void)
+{
+    static const uint8_t group[] =
+    {
+        0x50, 0x01, 0x41,
+        0x5A, 0x02, 0x12,0x34,
+        0x84, 0x00,
+        0x84, 0x01, 0x01,
+        0x9F,0x26, 0x81,0x01, 0x26,
+    };
+
+    static uint32_t memory[64];
+
+    bertlv_view_t view;
+    {
+        assert( BERTLV_OK == bertlv_view_parse(&view, memory, sizeof(memory), group, sizeof(group)) );
+        assert( 5 == bertlv_view_get_count(&view) );
+        assert( view.tags == memory );
+        assert( view.lengths == view.values + sizeof(memory) / 16 );
+
+        static const bertlv_tag_t tags   [] = { 0x50, 0x5A, 0x84, 0x84, 0x9F26 };
+        static const uint32_t     offsets[] = { 0, 3, 7, 9, 12 };
+        for(size_t i=view.count; i--; )
+        {
+            assert( tags[i] == bertlv_view_get_tag(&view, i) );
+            assert( group + offsets[i] == bertlv_view_get_tlv(&view, i) );
+        }
+
+        size_t length;
+        assert( group + 16 == bertlv_view_get_value(&view, 4, &length) && length == 1 );
+        assert( group + 5 == bertlv_view_get_value(&view, 1, &length) && length == 2 );
+        assert( !bertlv_view_get_tlv(&view, 5) && !bertlv_view_get_value(&view, 5, NULL) );
+
+        assert( 2 == bertlv_view_find_sorted(&view, 0x84) );
+        assert( 4 == bertlv_view_find_sorted(&view, 0x9F26) );
+        assert( 0 == bertlv_view_find_sorted(&view, 0x50) );
+        assert( BERTLV_VIEW_NONE == bertlv_view_find_sorted(&view, 0x70) );
+        assert( BERTLV_VIEW_NONE == bertlv_view_find_sorted(&view, 0xDF7F) );
+        assert( 1 == bertlv_view_find(&view, 0x5A) );
+        assert( BERTLV_VIEW_NONE == bertlv_view_find(&view, 0x70) );
+    }
+
+    {
+        // The memory be aligned, and its size includes the alignment padding.
+        uint8_t *buf = (uint8_t*)memory + 1;
+        assert( BERTLV_ERR_NO_SPACE == bertlv_view_parse(&view, buf, BERTLV_VIEW_BUFSIZE(5) - 4, group, sizeof(group)) );
+        assert( !view.count );
+        assert( BERTLV_OK == bertlv_view_parse(&view, buf, BERTLV_VIEW_BUFSIZE(5), group, sizeof(group)) );
+        assert( view.tags == memory + 1 && 5 == view.count );
+        assert( BERTLV_ERR_NO_SPACE == bertlv_view_parse(&view, NULL, 0, group, sizeof(group)) );
+
+        assert( BERTLV_ERR_OVERRUN == bertlv_view_parse(&view, memory, sizeof(memory), group, sizeof(group) - 1) );
+
+        assert( BERTLV_OK == bertlv_view_parse(&view, memory, sizeof(memory), group, 0) );
+        assert( !view.count );
+    }
+
+    if( sizeof(bertlv_tag_t) > sizeof(uint32_t) )
+    {
+        static const uint8_t longtag[] = { 0xDF, 0x81, 0x82, 0x83, 0x01, 0x00 };
+        assert( BERTLV_ERR_TAG_TOO_LONG == bertlv_view_parse(&view, memory, sizeof(memory), longtag, sizeof(longtag)) );
+        assert( BERTLV_VIEW_NONE == bertlv_view_find(&view, (bertlv_tag_t)0xDF81828301ULL) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_edit(void)
+{
+    static const bertlv_tag_t path_9f26[] = { 0x70, 0x77, 0x9F26 };
+    static const bertlv_tag_t path_a5  [] = { 0x6F, 0xA5 };
+    static const bertlv_tag_t path_84  [] = { 0x6F, 0x84 };
+
+    {
+        // Same payload size, and nothing else be changed.
+        uint8_t buf[sizeof(nested_msg)];
+        size_t  size = sizeof(nested_msg);
+        memcpy(buf, nested_msg, size);
+
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), path_9f26, 3, (uint8_t[]){ 0x55 }, 1) );
+        assert( size == sizeof(nested_msg) );
+        assert( buf[23] == 0x55 );
+        assert( 0 == memcmp(buf, nested_msg, 23) );
+        assert( 0 == memcmp(buf + 24, nested_msg + 24, 4) );
+    }
+
+    {
+        static const uint8_t big[200] = {0};
+
+        uint8_t buf[512], expected[512];
+        size_t  size = sizeof(nested_msg);
+        memcpy(buf, nested_msg, size);
+
+        assert( BERTLV_ERR_NO_SPACE == bertlv_edit_replace(buf, &size, 100, path_9f26, 3, big, sizeof(big)) );
+        assert( size == sizeof(nested_msg) && 0 == memcmp(buf, nested_msg, size) );
+
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), path_9f26, 3, big, sizeof(big)) );
+
+        memcpy(expected, nested_msg, 16);
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, expected + 16, sizeof(expected) - 16);
+        bertlv_builder_begin(&builder, 0x70, 0);
+            bertlv_builder_begin(&builder, 0x77, 0);
+                bertlv_builder_append(&builder, 0x9F26, big, sizeof(big));
+            bertlv_builder_end(&builder);
+            bertlv_builder_append(&builder, 0x5A, (uint8_t[]){ 0x12,0x34 }, 2);
+        bertlv_builder_end(&builder);
+        assert( size == 16 + bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, expected, size) );
+
+        // Length fields be re-encoded in the minimal form when the data shrinks.
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), path_9f26, 3, (uint8_t[]){ 0x26 }, 1) );
+        assert( size == sizeof(nested_msg) );
+        assert( 0 == memcmp(buf, nested_msg, size) );
+
+        unsigned violations;
+        assert( BERTLV_OK == bertlv_der_check(buf, size, 0, &violations) && !violations );
+    }
+
+    {
+        // Non-minimal length fields be re-encoded only if their lengths be changed.
+        static const uint8_t loose[] =
+        {
+            0x70, 0x81, 0x0C,
+                0x77, 0x81, 0x05,
+                    0x9F,0x26, 0x81,0x01, 0x26,
+                0x5A, 0x02, 0x12,0x34,
+        };
+        static const uint8_t replaced[] =
+        {
+            0x70, 0x81, 0x0C,
+                0x77, 0x06,
+                    0x9F,0x26, 0x03, 0x26,0x27,0x28,
+                0x5A, 0x02, 0x12,0x34,
+        };
+
+        uint8_t buf[64];
+        size_t  size = sizeof(loose);
+        memcpy(buf, loose, size);
+
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), path_9f26, 3, (uint8_t[]){ 0x26,0x27,0x28 }, 3) );
+        assert( size == sizeof(replaced) );
+        assert( 0 == memcmp(buf, replaced, size) );
+    }
+
+    {
+        static const uint8_t inserted[] =
+        {
+            0x6F, 0x13,
+                0x84, 0x02, 0xA0,0x00,
+                0xA5, 0x0D,
+                    0x50, 0x01, 0x41,
+                    0xBF,0x0C, 0x00,
+                    0x87, 0x00,
+                    0x9F,0x36, 0x02, 0x00,0x01,
+        };
+
+        uint8_t buf[64];
+        size_t  size = sizeof(nested_msg);
+        memcpy(buf, nested_msg, size);
+
+        assert( BERTLV_OK == bertlv_edit_insert(buf, &size, sizeof(buf), path_a5, 2, 0x9F36, (uint8_t[]){ 0x00,0x01 }, 2) );
+        assert( size == sizeof(inserted) + 12 );
+        assert( 0 == memcmp(buf, inserted, sizeof(inserted)) );
+        assert( 0 == memcmp(buf + sizeof(inserted), nested_msg + 16, 12) );
+
+        assert( BERTLV_OK == bertlv_edit_delete(buf, &size, path_a5, 2) );
+        assert( BERTLV_OK == bertlv_edit_delete(buf, &size, path_84, 2) );
+        assert( size == 2 + 12 );
+        assert( buf[0] == 0x6F && buf[1] == 0x00 );
+        assert( 0 == memcmp(buf + 2, nested_msg + 16, 12) );
+
+        assert( BERTLV_OK == bertlv_edit_insert(buf, &size, sizeof(buf), NULL, 0, 0x5F20, "AB", 2) );
+        assert( size == 2 + 12 + 5 );
+        assert( 0 == memcmp(buf + 14, "\x5F\x20\x02" "AB", 5) );
+
+        assert( BERTLV_ERR_MISSING_FIELD == bertlv_edit_delete(buf, &size, path_84, 2) );
+        assert( BERTLV_ERR_INVALID_FIELD == bertlv_edit_insert(buf, &size, sizeof(buf), (bertlv_tag_t[]){ 0x5F20 }, 1, 0x50, NULL, 0) );
+        assert( size == 2 + 12 + 5 );
+
+        // Malformed tags are not written.
+        assert( BERTLV_ERR_INVALID_FIELD == bertlv_edit_insert(buf, &size, sizeof(buf), NULL, 0, 0x1F, "AB", 2) );
+        assert( BERTLV_ERR_INVALID_FIELD == bertlv_edit_insert(buf, &size, sizeof(buf), NULL, 0, 0x9F81, "AB", 2) );
+        assert( BERTLV_ERR_INVALID_FIELD == bertlv_edit_insert(buf, &size, sizeof(buf), NULL, 0, 0, "AB", 2) );
+        assert( size == 2 + 12 + 5 );
+        assert( 0 == memcmp(buf + 14, "\x5F\x20\x02" "AB", 5) );
+    }
+}
+//------------------------------------------------------------------------------
+static const uint8_t indefinite_msg[] =
+{
+    0x6F, 0x80,                             // 6F
+        0x84, 0x02, 0xA0,0x00,              //   84
+        0xA5, 0x80,                         //   A5
+            0x50, 0x01, 0x41,               //     50
+            0xBF,0x0C, 0x00,                //     BF0C
+            0x87, 0x00,                     //     87
+        0x00, 0x00,                         //   End of A5
+    0x00, 0x00,                             // End of 6F
+    0x70, 0x0C,                             // 70
+        0x77, 0x80,                         //   77
+            0x9F,0x26, 0x01, 0x26,          //     9F26
+        0x00, 0x00,                         //   End of 77
+        0x5A, 0x02, 0x12,0x34,              //   5A
+};
+
+void test_tlv_indefinite(void)
+{
+    {
+        bertlv_header_t header;
+        assert( BERTLV_OK == bertlv_decode_header_s(indefinite_msg, sizeof(indefinite_msg), &header) );
+        assert( header.indefinite );
+        assert( header.tag == 0x6F && header.len_size == 1 );
+        assert( header.value == indefinite_msg + 2 && header.length == 16 );
+        assert( header.total_size == 20 );
+
+        assert( BERTLV_ERR_OVERRUN == bertlv_decode_header_s(indefinite_msg, 19, &header) );
+        assert( BERTLV_ERR_BAD_LENGTH == bertlv_decode_header_s((uint8_t[]){ 0x5A, 0x80, 0x00, 0x00 }, 4, &header) );
+        assert( 2 == bertlv_grp_count(indefinite_msg, sizeof(indefinite_msg)) );
+    }
+
+    {
+        // Same elements as the definite one, except the lengths.
+        bertlv_tree_iter_t iter1, iter2;
+        bertlv_tree_iter_init(&iter1, nested_msg, sizeof(nested_msg));
+        bertlv_tree_iter_init(&iter2, indefinite_msg, sizeof(indefinite_msg));
+
+        bertlv_header_t header1, header2;
+        while( bertlv_tree_iter_get_next(&iter1, &header1) )
+        {
+            assert( bertlv_tree_iter_get_next(&iter2, &header2) );
+            assert( header1.tag == header2.tag );
+            if( bertlv_tag_get_type(header1.tag) == BERTLV_TYPE_PRIMITIVE )
+            {
+                assert( header1.length == header2.length );
+                assert( 0 == memcmp(header1.value, header2.value, header1.length) );
+            }
+            assert( bertlv_tree_iter_get_depth(&iter1) == bertlv_tree_iter_get_depth(&iter2) );
+        }
+
+        assert( !bertlv_tree_iter_get_next(&iter2, &header2) );
+        assert( BERTLV_OK == bertlv_tree_iter_get_error(&iter2) );
+
+        static const bertlv_tag_t path[] = { 0x70, 0x77, 0x9F26 };
+        assert( indefinite_msg + 24 == bertlv_find_path(indefinite_msg, sizeof(indefinite_msg), path, 3) );
+    }
+
+    {
+        uint8_t buf[64];
+        assert( sizeof(nested_msg) == bertlv_resolve_indefinite(NULL, 0, indefinite_msg, sizeof(indefinite_msg)) );
+        assert( 0 == bertlv_resolve_indefinite(buf, sizeof(nested_msg) - 1, indefinite_msg, sizeof(indefinite_msg)) );
+        assert( sizeof(nested_msg) == bertlv_resolve_indefinite(buf, sizeof(buf), indefinite_msg, sizeof(indefinite_msg)) );
+        assert( 0 == memcmp(buf, nested_msg, sizeof(nested_msg)) );
+        assert( 0 == bertlv_resolve_indefinite(buf, sizeof(buf), indefinite_msg, sizeof(indefinite_msg) - 1) );
+    }
+
+    {
+        // The long payload needs long form length fields on all levels.
+        static uint8_t input[4 + 3 + 200 + 4];
+        static uint8_t expected[3 + 3 + 3 + 200];
+        memcpy(input, (uint8_t[]){ 0xE1, 0x80, 0xE2, 0x80, 0xC1, 0x81, 0xC8 }, 7);
+        memcpy(expected, (uint8_t[]){ 0xE1, 0x81, 0xCE, 0xE2, 0x81, 0xCB, 0xC1, 0x81, 0xC8 }, 9);
+        for(size_t i=0; i<200; ++i)
+            input[7+i] = expected[9+i] = i;
+
+        static uint8_t buf[sizeof(expected)];
+        assert( sizeof(expected) == bertlv_resolve_indefinite(NULL, 0, input, sizeof(input)) );
+        assert( 0 == bertlv_resolve_indefinite(buf, sizeof(buf) - 1, input, sizeof(input)) );
+        assert( sizeof(expected) == bertlv_resolve_indefinite(buf, sizeof(buf), input, sizeof(input)) );
+        assert( 0 == memcmp(buf, expected, sizeof(expected)) );
+    }
+
+    {
+        uint8_t buf[64];
+        bertlv_builder_t builder;
+        bertlv_builder_init(&builder, buf, sizeof(buf));
+
+        bertlv_builder_begin(&builder, 0x6F, BERTLV_LEN_INDEFINITE);
+            bertlv_builder_append(&builder, 0x84, (uint8_t[]){ 0xA0,0x00 }, 2);
+            bertlv_builder_begin(&builder, 0xA5, BERTLV_LEN_INDEFINITE);
+                bertlv_builder_append(&builder, 0x50, (uint8_t[]){ 0x41 }, 1);
+                bertlv_builder_begin(&builder, 0xBF0C, 0);
+                bertlv_builder_end(&builder);
+                bertlv_builder_append(&builder, 0x87, NULL, 0);
+            bertlv_builder_end(&builder);
+        bertlv_builder_end(&builder);
+        bertlv_builder_begin(&builder, 0x70, 0);
+            bertlv_builder_begin(&builder, 0x77, BERTLV_LEN_INDEFINITE);
+                bertlv_builder_append(&builder, 0x9F26, (uint8_t[]){ 0x26 }, 1);
+            bertlv_builder_end(&builder);
+            bertlv_builder_append(&builder, 0x5A, (uint8_t[]){ 0x12,0x34 }, 2);
+        bertlv_builder_end(&builder);
+
+        assert( sizeof(indefinite_msg) == bertlv_builder_finish(&builder) );
+        assert( 0 == memcmp(buf, indefinite_msg, sizeof(indefinite_msg)) );
+    }
+
+    {
+        // The streaming parser reports the same events as the definite one.
+        stream_log_t expected = {0};
+        bertlv_stream_t stream;
+        bertlv_stream_init(&stream, stream_log_event, &expected);
+        assert( BERTLV_OK == bertlv_stream_feed(&stream, nested_msg, sizeof(nested_msg)) );
+
+        for(size_t chunk = 1; chunk <= sizeof(indefinite_msg); ++chunk)
+        {
+            stream_log_t log = {0};
+            bertlv_stream_init(&stream, stream_log_event, &log);
+
+            for(size_t pos = 0; pos < sizeof(indefinite_msg); pos += chunk)
+            {
+                size_t size = ( sizeof(indefinite_msg) - pos < chunk )?( sizeof(indefinite_msg) - pos ):( chunk );
+                assert( BERTLV_OK == bertlv_stream_feed(&stream, indefinite_msg + pos, size) );
+            }
+
+            assert( BERTLV_OK == bertlv_stream_finish(&stream) );
+            assert( expected.count == log.count );
+            assert( 0 == memcmp(log.types,  expected.types,  sizeof(expected.types)) );
+            assert( 0 == memcmp(log.tags,   expected.tags,   sizeof(expected.tags)) );
+            assert( 0 == memcmp(log.depths, expected.depths, sizeof(expected.depths)) );
+            assert( expected.value_size == log.value_size );
+            assert( 0 == memcmp(log.values, expected.values, log.value_size) );
+        }
+
+        stream_log_t log = {0};
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_OK == bertlv_stream_feed(&stream, indefinite_msg, 19) );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_stream_finish(&stream) );
+
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_ERR_BAD_LENGTH == bertlv_stream_feed(&stream, (uint8_t[]){ 0x70, 0x80, 0x00, 0x01 }, 4) );
+
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_ERR_BAD_LENGTH == bertlv_stream_feed(&stream, (uint8_t[]){ 0x5A, 0x80 }, 2) );
+
+        // End-of-contents is not allowed in a definite length element.
+        bertlv_stream_init(&stream, stream_log_event, &log);
+        assert( BERTLV_ERR_NULL_TAG == bertlv_stream_feed(&stream, (uint8_t[]){ 0x70, 0x02, 0x00, 0x00 }, 4) );
+    }
+
+    {
+        // Indefinite lengths of ancestors keep unchanged on editing.
+        static const bertlv_tag_t path[] = { 0x6F, 0xA5, 0x50 };
+
+        uint8_t buf[64];
+        size_t  size = sizeof(indefinite_msg);
+        memcpy(buf, indefinite_msg, size);
+
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), path, 3, "ABC", 3) );
+        assert( size == sizeof(indefinite_msg) + 2 );
+        assert( buf[1] == 0x80 && buf[7] == 0x80 );
+        assert( 0 == memcmp(buf + 8, "\x50\x03" "ABC", 5) );
+        assert( 2 == bertlv_grp_count(buf, size) );
+    }
+
+    {
+        // The indefinite mark of a child moves with the length field of its definite parent.
+        static const bertlv_tag_t inner[] = { 0x70, 0x70 };
+        static const bertlv_tag_t first[] = { 0x70, 0x70, 0xC1 };
+        static const bertlv_tag_t added[] = { 0x70, 0x70, 0xC2 };
+
+        static uint8_t buf[512];
+        static uint8_t value[251];
+        memset(value, 0xAA, sizeof(value));
+
+        size_t size;
+        memcpy(buf, (uint8_t[]){ 0x70, 0x81, 0x89, 0x70, 0x80, 0xC1, 0x81, 0x82 }, 8);
+        memset(buf + 8, 0x55, 130);
+        memcpy(buf + 138, (uint8_t[]){ 0x00, 0x00 }, 2);
+        size = 140;
+
+        bertlv_header_t header;
+        assert( BERTLV_OK == bertlv_edit_insert(buf, &size, sizeof(buf), inner, 2, 0xC2, value, sizeof(value)) );
+        assert( size == 395 );
+        assert( 0 == memcmp(buf, "\x70\x82\x01\x87" "\x70\x80" "\xC1\x81\x82", 9) );
+        assert( 0 == memcmp(buf + 139, "\xC2\x81\xFB", 3) && 0 == memcmp(buf + 142, value, sizeof(value)) );
+        assert( BERTLV_OK == bertlv_decode_header_s(buf + 4, size - 4, &header) );
+        assert( header.indefinite && header.total_size == 391 );
+
+        assert( BERTLV_OK == bertlv_edit_replace(buf, &size, sizeof(buf), first, 3, "\x11", 1) );
+        assert( size == 265 );
+        assert( 0 == memcmp(buf, "\x70\x82\x01\x05" "\x70\x80" "\xC1\x01\x11" "\xC2\x81\xFB", 12) );
+        assert( BERTLV_OK == bertlv_decode_header_s(buf + 4, size - 4, &header) );
+        assert( header.indefinite && header.total_size == 261 );
+
+        assert( BERTLV_OK == bertlv_edit_delete(buf, &size, added, 3) );
+        assert( size == 9 );
+        assert( 0 == memcmp(buf, "\x70\x07" "\x70\x80" "\xC1\x01\x11" "\x00\x00", 9) );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_der(void)
+{
+    unsigned violations;
+
+    {
+        assert( BERTLV_OK == bertlv_der_check(nested_msg, sizeof(nested_msg), BERTLV_DER_CHECK_ORDER, &violations) );
+        assert( 0 == violations );
+
+        assert( BERTLV_OK == bertlv_der_check(indefinite_msg, sizeof(indefinite_msg), 0, &violations) );
+        assert( BERTLV_DER_INDEFINITE == violations );
+
+        uint8_t buf[64];
+        assert( sizeof(nested_msg) == bertlv_der_canonicalize(buf, sizeof(buf), indefinite_msg, sizeof(indefinite_msg), 0) );
+        assert( 0 == memcmp(buf, nested_msg, sizeof(nested_msg)) );
+    }
+
+    {
+        static const uint8_t data[] = { 0x70, 0x81, 0x06, 0x1F,0x80,0x05, 0x81,0x01, 0xAA };
+        static const uint8_t canon[] = { 0x70, 0x03, 0x05, 0x01, 0xAA };
+
+        assert( BERTLV_OK == bertlv_der_check(data, sizeof(data), 0, &violations) );
+        assert( ( BERTLV_DER_LONG_TAG | BERTLV_DER_LONG_LENGTH ) == violations );
+        assert( BERTLV_OK == bertlv_der_check(data, sizeof(data), BERTLV_DER_LOW_TAGS, &violations) );
+        assert( ( BERTLV_DER_LONG_TAG | BERTLV_DER_LONG_LENGTH ) == violations );
+
+        uint8_t buf[16];
+        assert( sizeof(canon) == bertlv_der_canonicalize(NULL, 0, data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( 0 == bertlv_der_canonicalize(buf, sizeof(canon) - 1, data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( sizeof(canon) == bertlv_der_canonicalize(buf, sizeof(buf), data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( 0 == memcmp(buf, canon, sizeof(canon)) );
+
+        assert( BERTLV_OK == bertlv_der_check(buf, sizeof(canon), BERTLV_DER_LOW_TAGS, &violations) );
+        assert( 0 == violations );
+
+        // Multi-byte form of low tag numbers (like BF0C of EMV) is kept by default.
+        static const uint8_t keep[] = { 0x70, 0x04, 0x1F,0x05, 0x01, 0xAA };
+        assert( sizeof(keep) == bertlv_der_canonicalize(buf, sizeof(buf), data, sizeof(data), 0) );
+        assert( 0 == memcmp(buf, keep, sizeof(keep)) );
+        assert( BERTLV_OK == bertlv_der_check(buf, sizeof(keep), 0, &violations) );
+        assert( 0 == violations );
+        assert( BERTLV_OK == bertlv_der_check(buf, sizeof(keep), BERTLV_DER_LOW_TAGS, &violations) );
+        assert( BERTLV_DER_LONG_TAG == violations );
+
+        assert( BERTLV_ERR_OVERRUN == bertlv_der_check(data, sizeof(data) - 1, 0, &violations) );
+    }
+
+    {
+        // Tags shrink while the resolved length of the parent needs the long form.
+        static uint8_t data [4 + 5 + 150 + 2];
+        static uint8_t canon[3 + 3 + 150];
+        memcpy(data,  (uint8_t[]){ 0x7F,0x80,0x01, 0x80, 0x1F,0x80,0x02, 0x81,0x96 }, 9);
+        memcpy(canon, (uint8_t[]){ 0x61, 0x81,0x99, 0x02, 0x81,0x96 }, 6);
+        for(size_t i=0; i<150; ++i)
+            data[9+i] = canon[6+i] = i;
+
+        static uint8_t buf[sizeof(canon)];
+        assert( sizeof(canon) == bertlv_der_canonicalize(NULL, 0, data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( 0 == bertlv_der_canonicalize(buf, sizeof(buf) - 1, data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( sizeof(canon) == bertlv_der_canonicalize(buf, sizeof(buf), data, sizeof(data), BERTLV_DER_LOW_TAGS) );
+        assert( 0 == memcmp(buf, canon, sizeof(canon)) );
+
+        assert( BERTLV_OK == bertlv_der_check(buf, sizeof(canon), BERTLV_DER_LOW_TAGS, &violations) );
+        assert( 0 == violations );
+    }
+
+    {
+        static const uint8_t unordered[] = { 0x31, 0x06, 0x02,0x01,0x05, 0x02,0x01,0x03 };
+        static const uint8_t ordered  [] = { 0x31, 0x07, 0x02,0x01,0x03, 0x02,0x02,0x00,0x80 };
+        static const uint8_t sequence [] = { 0x30, 0x06, 0x02,0x01,0x05, 0x02,0x01,0x03 };
+
+        assert( BERTLV_OK == bertlv_der_check(unordered, sizeof(unordered), 0, &violations) );
+        assert( 0 == violations );
+        assert( BERTLV_OK == bertlv_der_check(unordered, sizeof(unordered), BERTLV_DER_CHECK_ORDER, &violations) );
+        assert( BERTLV_DER_UNORDERED == violations );
+        assert( BERTLV_OK == bertlv_der_check(ordered, sizeof(ordered), BERTLV_DER_CHECK_ORDER, &violations) );
+        assert( 0 == violations );
+        assert( BERTLV_OK == bertlv_der_check(sequence, sizeof(sequence), BERTLV_DER_CHECK_ORDER, &violations) );
+        assert( 0 == violations );
+    }
+}
+//------------------------------------------------------------------------------
+void test_tlv_len64(void)
+{
+    {
+        static const uint8_t field[] = { 0x85, 0x01,0x40,0x00,0x00,0x00 };
+
+        uint8_t buf[16];
+        assert( sizeof(field) == bertlv_len_encode64(NULL, 0, 0x140000000ULL) );
+        assert( 0 == bertlv_len_encode64(buf, sizeof(field) - 1, 0x140000000ULL) );
+        assert( sizeof(field) == bertlv_len_encode64(buf, sizeof(buf), 0x140000000ULL) );
+        assert( 0 == memcmp(buf, field, sizeof(field)) );
+        assert( 9 == bertlv_len_encode64(buf, sizeof(buf), UINT64_MAX) );
+
+        uint64_t length;
+        size_t   lensize;
+        assert( BERTLV_OK == bertlv_len_decode64(field, sizeof(field), &length, &lensize) );
+        assert( length == 0x140000000ULL && lensize == sizeof(field) );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_len_decode64(field, sizeof(field) - 1, &length, &lensize) );
+        assert( BERTLV_OK == bertlv_len_decode64(buf, 9, &length, &lensize) );
+        assert( length == UINT64_MAX && lensize == 9 );
+        assert( BERTLV_ERR_BAD_LENGTH == bertlv_len_decode64((uint8_t[]){ 0x80 }, 1, &length, &lensize) );
+        assert( BERTLV_ERR_LENGTH_TOO_LONG == bertlv_len_decode64((uint8_t[]){ 0x89 }, 1, &length, &lensize) );
+    }
+
+    {
+        // A header of 5 GB element, and its payload is not here.
+        static const uint8_t tlv[] = { 0xDF,0x07, 0x85, 0x01,0x40,0x00,0x00,0x00, 0x00 };
+
+        bertlv_header64_t header;
+        assert( BERTLV_OK == bertlv_decode_header64(tlv, sizeof(tlv), &header) );
+        assert( header.tag == 0xDF07 && header.tag_size == 2 && header.len_size == 6 );
+        assert( header.length == 0x140000000ULL && header.total_size == 0x140000008ULL );
+        assert( !header.indefinite );
+
+        bertlv_header_t header_s;
+        assert( BERTLV_ERR_OVERRUN == bertlv_decode_header_s(tlv, sizeof(tlv), &header_s) );
+        assert( 0 == bertlv_grp_count(tlv, sizeof(tlv)) );
+    }
+
+    {
+        // The total size overflows.
+        static const uint8_t tlv[] = { 0xC1, 0x88, 0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF };
+
+        bertlv_header64_t header;
+        assert( BERTLV_ERR_LENGTH_TOO_LONG == bertlv_decode_header64(tlv, sizeof(tlv), &header) );
+
+        bertlv_header_t header_s;
+        assert( BERTLV_ERR_OVERRUN == bertlv_decode_header_s(tlv, sizeof(tlv), &header_s) );
+        assert( 0 == bertlv_decode_header(tlv, &header_s) );
+        assert( 0 == bertlv_get_total_size(tlv) );
+    }
+
+    {
+        bertlv_header64_t header;
+        assert( BERTLV_OK == bertlv_decode_header64(indefinite_msg, 2, &header) );
+        assert( header.indefinite && header.total_size == 0 );
+        assert( BERTLV_ERR_TRUNCATED == bertlv_decode_header64(indefinite_msg, 1, &header) );
+    }
+}
+//------------------------------------------------------------------------------
+#ifdef BERTLV_STATS
+static bool stats_accept_all(void *arg, const bertlv_event_t *event)
+{
+    return true;
+}
+#endif
+//------------------------------------------------------------------------------
+static void test_tlv_stats(void)
+{
+#ifdef BERTLV_STATS
+    bertlv_stats_t stats;
+
+    // Iterator.
+    {
+        bertlv_stats_reset();
+
+        bertlv_iter_t iter;
+        bertlv_iter_init(&iter, nested_msg, sizeof(nested_msg));
+        while( bertlv_iter_get_next(&iter) )
+        {}
+
+        bertlv_stats_get(&stats);
+        assert( stats.elements  == 2 );
+        assert( stats.bytes     == sizeof(nested_msg) );
+        assert( stats.max_depth == 0 );
+    }
+
+    // Tree iterator.
+    {
+        bertlv_stats_reset();
+
+        bertlv_tree_iter_t iter;
+        bertlv_tree_iter_init(&iter, nested_msg, sizeof(nested_msg));
+
+        bertlv_header_t header;
+        while( bertlv_tree_iter_get_next(&iter, &header) )
+        {}
+
+        bertlv_stats_get(&stats);
+        assert( stats.elements  == 10 );
+        assert( stats.bytes     == 64 );
+        assert( stats.max_depth == 2 );
+    }
+
+    // Streaming parser.
+    {
+        bertlv_stats_reset();
+
+        bertlv_stream_t stream;
+        bertlv_stream_init(&stream, stats_accept_all, NULL);
+        assert( BERTLV_OK == bertlv_stream_feed(&stream, nested_msg, sizeof(nested_msg)) );
+
+        bertlv_stats_get(&stats);
+        assert( stats.elements  == 10 );
+        assert( stats.bytes     == 64 );
+        assert( stats.max_depth == 2 );
+    }
+
+    // Failures be counted once by reason.
+    {
+        static const uint8_t padded[] = { 0x5A, 0x01, 0x12, 0x00, 0x00 };
+
+        bertlv_stats_reset();
+
+        bertlv_iter_t iter;
+        bertlv_iter_init(&iter, padded, sizeof(padded));
+        while( bertlv_iter_get_next(&iter) )
+        {}
+        assert( !bertlv_iter_get_next(&iter) );
+
+        assert( 1 == bertlv_grp_count(padded, sizeof(padded)) );
+
+        bertlv_stats_get(&stats);
+        assert( stats.elements == 2 );
+        assert( stats.failures[BERTLV_ERR_NULL_TAG] == 2 );
+        assert( stats.failures[BERTLV_ERR_TRUNCATED] == 0 );
+    }
+#endif
+}
+//------------------------------------------------------------------------------
 int main(void)
 {
     test_tags();
     test_tlv_elements();
     test_tlv_group();
+    test_bounds_checking();
+    test_tlv_index();
+    test_tlv_tree();
+    test_tlv_builder();
+    test_tlv_rwriter();
+    test_tlv_stream();
+    test_tlv_file();
+    test_tlv_par();
+    test_tlv_scan();
+    test_tlv_schema();
+    test_tlv_plan();
+    test_tlv_iov();
+    test_tlv_dom();
+    test_tlv_view();
+    test_tlv_edit();
+    test_tlv_indefinite();
+    test_tlv_der();
+    test_tlv_len64();
+    test_tlv_stats();
+    test_tlv_hpp();
 
     return 0;
 }
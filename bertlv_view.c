@@ -0,0 +1,115 @@
+#include <string.h>
+#include "bertlv_view.h"
+
+//------------------------------------------------------------------------------
+int bertlv_view_parse(bertlv_view_t *view, void *buf, size_t bufsize, const void *group, size_t size)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Index the top level elements of a TLV group.
+     *
+     * @param view    The object to receive the result.
+     * @param buf     The memory to hold the arrays of the view,
+     *                see ::BERTLV_VIEW_BUFSIZE for its size.
+     * @param bufsize Size of the memory.
+     * @param group   A set of data of TLV elements.
+     * @param size    Size of the input data.
+     * @return ::BERTLV_OK if succeed; or
+     *         ::BERTLV_ERR_NO_SPACE if the memory cannot hold all elements; or
+     *         ::BERTLV_ERR_LENGTH_TOO_LONG if the group is larger than 32-bit offsets can address; or
+     *         ::BERTLV_ERR_TAG_TOO_LONG if a tag cannot be held in 32 bits; or
+     *         one of ::bertlv_error_t if failed.
+     *
+     * @remarks The group be walked only once, and
+     *          the arrays be laid out by the capacity of the memory,
+     *          so the view refers to the memory until it be parsed again.
+     */
+    memset(view, 0, sizeof(*view));
+    view->group = group;
+
+    if( size > UINT32_MAX ) return BERTLV_ERR_LENGTH_TOO_LONG;
+
+    size_t pad = ( sizeof(uint32_t) - (uintptr_t)buf % sizeof(uint32_t) ) % sizeof(uint32_t);
+    if( !buf || bufsize < pad ) return BERTLV_ERR_NO_SPACE;
+
+    size_t    capacity = ( bufsize - pad ) / ( 4 * sizeof(uint32_t) );
+    uint32_t *tags     = (uint32_t*)( (uint8_t*)buf + pad );
+    uint32_t *offsets  = tags    + capacity;
+    uint32_t *values   = offsets + capacity;
+    uint32_t *lengths  = values  + capacity;
+
+    bertlv_iter_t iter;
+    bertlv_iter_init(&iter, group, size);
+
+    size_t          count = 0;
+    bertlv_header_t header;
+    for(const uint8_t *tlv; ( tlv = bertlv_iter_get_next_header(&iter, &header) ); ++count)
+    {
+        if( count >= capacity ) return BERTLV_ERR_NO_SPACE;
+        if( header.tag > UINT32_MAX ) return BERTLV_ERR_TAG_TOO_LONG;
+
+        tags   [count] = header.tag;
+        offsets[count] = tlv - view->group;
+        values [count] = (const uint8_t*)header.value - view->group;
+        lengths[count] = header.length;
+    }
+
+    int err = bertlv_iter_get_error(&iter);
+    if( err ) return err;
+
+    view->tags    = tags;
+    view->offsets = offsets;
+    view->values  = values;
+    view->lengths = lengths;
+    view->count   = count;
+
+    return BERTLV_OK;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_view_find(const bertlv_view_t *view, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Find an element by tag.
+     *
+     * @param view The view object.
+     * @param tag  The tag to search.
+     * @return Index of the first element which has the tag if found; or
+     *         ::BERTLV_VIEW_NONE if not.
+     */
+    if( tag > UINT32_MAX ) return BERTLV_VIEW_NONE;
+
+    for(size_t i=0; i<view->count; ++i)
+    {
+        if( view->tags[i] == tag ) return i;
+    }
+
+    return BERTLV_VIEW_NONE;
+}
+//------------------------------------------------------------------------------
+size_t bertlv_view_find_sorted(const bertlv_view_t *view, bertlv_tag_t tag)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Find an element by tag with binary search.
+     *
+     * @param view The view object, its elements must be sorted by ascending tag values.
+     * @param tag  The tag to search.
+     * @return Index of the first element which has the tag if found; or
+     *         ::BERTLV_VIEW_NONE if not.
+     */
+    if( tag > UINT32_MAX ) return BERTLV_VIEW_NONE;
+
+    size_t low = 0, high = view->count;
+    while( low < high )
+    {
+        size_t mid = low + ( high - low ) / 2;
+        if( view->tags[mid] < tag )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return ( low < view->count && view->tags[low] == tag )?( low ):( BERTLV_VIEW_NONE );
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief     BER-TLV group view.
+ * @details   Index a flat group into parallel arrays of 32-bit fields for random access.
+ * @copyright ZLib Licence
+ */
+#ifndef _BERTLV_VIEW_H_
+#define _BERTLV_VIEW_H_
+
+#include "bertlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Index value that refers to no element of a view.
+ */
+#define BERTLV_VIEW_NONE SIZE_MAX
+
+/**
+ * Size of buffer that a view of a number of elements needs.
+ */
+#define BERTLV_VIEW_BUFSIZE(count) ( (count) * 4 * sizeof(uint32_t) + sizeof(uint32_t) - 1 )
+
+/**
+ * @class bertlv_view_t
+ * @brief Random access view of a flat TLV group.
+ * @details The position and header of each element be recorded in parallel arrays,
+ *          so that any element can be accessed by index directly,
+ *          and the tags be searched without touching the input data.
+ *          All fields are 32-bit, so one element costs 16 bytes,
+ *          the group cannot exceed 4GB, and tags cannot be longer than 4 bytes.
+ */
+typedef struct bertlv_view_t
+{
+    const uint8_t *group;
+    uint32_t      *tags;        ///< Tag of each element.
+    uint32_t      *offsets;     ///< Offset of each element in the group.
+    uint32_t      *values;      ///< Offset of the payload of each element in the group.
+    uint32_t      *lengths;     ///< Payload size of each element.
+    size_t         count;       ///< Number of elements.
+} bertlv_view_t;
+
+int    bertlv_view_parse(bertlv_view_t *view, void *buf, size_t bufsize, const void *group, size_t size);
+size_t bertlv_view_find(const bertlv_view_t *view, bertlv_tag_t tag);
+size_t bertlv_view_find_sorted(const bertlv_view_t *view, bertlv_tag_t tag);
+
+static inline
+size_t bertlv_view_get_count(const bertlv_view_t *view)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Get the number of elements.
+     */
+    return view->count;
+}
+
+static inline
+const void* bertlv_view_get_tlv(const bertlv_view_t *view, size_t index)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Get an element by its index.
+     *
+     * @return The TLV element if the index is valid; or NULL if not.
+     */
+    return index < view->count ? view->group + view->offsets[index] : NULL;
+}
+
+static inline
+bertlv_tag_t bertlv_view_get_tag(const bertlv_view_t *view, size_t index)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Get tag of an element by its index.
+     *
+     * @return Tag of the element if the index is valid; or ZERO if not.
+     */
+    return index < view->count ? view->tags[index] : 0;
+}
+
+static inline
+const void* bertlv_view_get_value(const bertlv_view_t *view, size_t index, size_t *length)
+{
+    /**
+     * @memberof bertlv_view_t
+     * @brief Get payload of an element by its index.
+     *
+     * @param view   The view object.
+     * @param index  Index of the element.
+     * @param length Receives the payload size (can be NULL).
+     * @return The payload data if the index is valid; or NULL if not.
+     */
+    if( index >= view->count ) return NULL;
+
+    if( length ) *length = view->lengths[index];
+    return view->group + view->values[index];
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif